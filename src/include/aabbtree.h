@@ -0,0 +1,457 @@
+#define AABB_TREE_NULL -1
+// how far a leaf's box is grown past the object's tight box, in pixels
+#define AABB_TREE_MARGIN 4.0f
+// how many frames of motion a leaf's box is stretched by in the direction of travel
+#define AABB_TREE_PREDICTION 1.0f
+
+typedef struct {
+	AABB box; // fattened for leaves, the union of both children otherwise
+	int parent; // doubles as the next link while the node is on the free list
+	int child1;
+	int child2;
+	int height; // 0 for leaves, -1 while free
+	int objectIndex; // -1 once the object is removed
+	bool moved;
+} aabbTreeNode;
+
+// incremental dynamic bounding volume tree.
+// leaves hold fat boxes and are only reinserted once an object's tight box escapes its fat box,
+// so overlapping pairs are kept from step to step and only re-queried for leaves that moved.
+// the pairs are kept as leaves, which don't move around like objects do. a removed object's
+// leaf leaves the tree straight away, but only gets freed along with its pairs on the next update
+typedef struct {
+	aabbTreeNode *nodes;
+	int nodeCapacity;
+	int freeList;
+	int root;
+
+	int *leafOfObject;
+	int leafCapacity;
+	int numObjects;
+
+	int *movedLeaves;
+	int moveCount;
+	int moveCapacity;
+
+	int *removedLeaves;
+	int removedCount;
+	int removedCapacity;
+
+	int *stack;
+	int stackCapacity;
+
+	pairList leafPairs;
+	pairList pairs; // leafPairs by object index, rebuilt every update
+} aabbTree;
+
+AABB combineAABB(AABB box1, AABB box2) {
+	return (AABB){
+		(Vector2){fminf(box1.min.x, box2.min.x), fminf(box1.min.y, box2.min.y)},
+		(Vector2){fmaxf(box1.max.x, box2.max.x), fmaxf(box1.max.y, box2.max.y)}
+	};
+}
+
+float getAABBPerimeter(AABB box) {
+	return 2.0f * ((box.max.x - box.min.x) + (box.max.y - box.min.y));
+}
+
+bool AABBContains(AABB *outer, AABB *inner) {
+	return outer->min.x <= inner->min.x &&
+		outer->min.y <= inner->min.y &&
+		outer->max.x >= inner->max.x &&
+		outer->max.y >= inner->max.y;
+}
+
+void initAABBTree(aabbTree *tree) {
+	*tree = (aabbTree){0};
+	tree->root = AABB_TREE_NULL;
+	tree->freeList = AABB_TREE_NULL;
+}
+
+int allocateTreeNode(aabbTree *tree) {
+	if (tree->freeList == AABB_TREE_NULL) {
+		int oldCapacity = tree->nodeCapacity;
+		tree->nodes = growArray(tree->nodes, &tree->nodeCapacity, oldCapacity + 1, sizeof(aabbTreeNode));
+		// chain the new nodes onto the free list
+		for (int i = oldCapacity; i < tree->nodeCapacity; i++) {
+			tree->nodes[i].parent = i + 1 < tree->nodeCapacity ? i + 1 : AABB_TREE_NULL;
+			tree->nodes[i].height = -1;
+		}
+		tree->freeList = oldCapacity;
+	}
+	int nodeIndex = tree->freeList;
+	aabbTreeNode *node = &tree->nodes[nodeIndex];
+	tree->freeList = node->parent;
+	node->parent = AABB_TREE_NULL;
+	node->child1 = AABB_TREE_NULL;
+	node->child2 = AABB_TREE_NULL;
+	node->height = 0;
+	node->objectIndex = -1;
+	node->moved = false;
+	return nodeIndex;
+}
+
+void freeTreeNode(aabbTree *tree, int nodeIndex) {
+	tree->nodes[nodeIndex].parent = tree->freeList;
+	tree->nodes[nodeIndex].height = -1;
+	tree->freeList = nodeIndex;
+}
+
+bool isTreeLeaf(aabbTreeNode *node) {
+	return node->child1 == AABB_TREE_NULL;
+}
+
+// performs a left or right rotation if node A is imbalanced, returns the new subtree root
+int balanceTreeNode(aabbTree *tree, int iA) {
+	aabbTreeNode *nodes = tree->nodes;
+	aabbTreeNode *A = &nodes[iA];
+	if (isTreeLeaf(A) || A->height < 2) {
+		return iA;
+	}
+
+	int iB = A->child1;
+	int iC = A->child2;
+	aabbTreeNode *B = &nodes[iB];
+	aabbTreeNode *C = &nodes[iC];
+	int balance = C->height - B->height;
+
+	// rotate C up
+	if (balance > 1) {
+		int iF = C->child1;
+		int iG = C->child2;
+		aabbTreeNode *F = &nodes[iF];
+		aabbTreeNode *G = &nodes[iG];
+
+		C->child1 = iA;
+		C->parent = A->parent;
+		A->parent = iC;
+		if (C->parent != AABB_TREE_NULL) {
+			if (nodes[C->parent].child1 == iA) {
+				nodes[C->parent].child1 = iC;
+			} else {
+				nodes[C->parent].child2 = iC;
+			}
+		} else {
+			tree->root = iC;
+		}
+
+		if (F->height > G->height) {
+			C->child2 = iF;
+			A->child2 = iG;
+			G->parent = iA;
+			A->box = combineAABB(B->box, G->box);
+			C->box = combineAABB(A->box, F->box);
+			A->height = 1 + (B->height > G->height ? B->height : G->height);
+			C->height = 1 + (A->height > F->height ? A->height : F->height);
+		} else {
+			C->child2 = iG;
+			A->child2 = iF;
+			F->parent = iA;
+			A->box = combineAABB(B->box, F->box);
+			C->box = combineAABB(A->box, G->box);
+			A->height = 1 + (B->height > F->height ? B->height : F->height);
+			C->height = 1 + (A->height > G->height ? A->height : G->height);
+		}
+		return iC;
+	}
+
+	// rotate B up
+	if (balance < -1) {
+		int iD = B->child1;
+		int iE = B->child2;
+		aabbTreeNode *D = &nodes[iD];
+		aabbTreeNode *E = &nodes[iE];
+
+		B->child1 = iA;
+		B->parent = A->parent;
+		A->parent = iB;
+		if (B->parent != AABB_TREE_NULL) {
+			if (nodes[B->parent].child1 == iA) {
+				nodes[B->parent].child1 = iB;
+			} else {
+				nodes[B->parent].child2 = iB;
+			}
+		} else {
+			tree->root = iB;
+		}
+
+		if (D->height > E->height) {
+			B->child2 = iD;
+			A->child1 = iE;
+			E->parent = iA;
+			A->box = combineAABB(C->box, E->box);
+			B->box = combineAABB(A->box, D->box);
+			A->height = 1 + (C->height > E->height ? C->height : E->height);
+			B->height = 1 + (A->height > D->height ? A->height : D->height);
+		} else {
+			B->child2 = iE;
+			A->child1 = iD;
+			D->parent = iA;
+			A->box = combineAABB(C->box, D->box);
+			B->box = combineAABB(A->box, E->box);
+			A->height = 1 + (C->height > D->height ? C->height : D->height);
+			B->height = 1 + (A->height > E->height ? A->height : E->height);
+		}
+		return iB;
+	}
+
+	return iA;
+}
+
+// walks from a node to the root, rebalancing and refitting every ancestor
+void refitTreeAncestors(aabbTree *tree, int nodeIndex) {
+	while (nodeIndex != AABB_TREE_NULL) {
+		nodeIndex = balanceTreeNode(tree, nodeIndex);
+		aabbTreeNode *node = &tree->nodes[nodeIndex];
+		aabbTreeNode *child1 = &tree->nodes[node->child1];
+		aabbTreeNode *child2 = &tree->nodes[node->child2];
+		node->height = 1 + (child1->height > child2->height ? child1->height : child2->height);
+		node->box = combineAABB(child1->box, child2->box);
+		nodeIndex = node->parent;
+	}
+}
+
+void insertTreeLeaf(aabbTree *tree, int leaf) {
+	if (tree->root == AABB_TREE_NULL) {
+		tree->root = leaf;
+		tree->nodes[leaf].parent = AABB_TREE_NULL;
+		return;
+	}
+
+	// find the best sibling using the surface area (perimeter in 2d) heuristic
+	AABB leafBox = tree->nodes[leaf].box;
+	int index = tree->root;
+	while (!isTreeLeaf(&tree->nodes[index])) {
+		aabbTreeNode *node = &tree->nodes[index];
+		float area = getAABBPerimeter(node->box);
+		float combinedArea = getAABBPerimeter(combineAABB(node->box, leafBox));
+
+		// cost of making a new parent for this node and the leaf
+		float cost = 2.0f * combinedArea;
+		// minimum cost of pushing the leaf further down the tree
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float childCost[2];
+		int children[2] = {node->child1, node->child2};
+		for (int i = 0; i < 2; i++) {
+			aabbTreeNode *child = &tree->nodes[children[i]];
+			float newArea = getAABBPerimeter(combineAABB(leafBox, child->box));
+			if (isTreeLeaf(child)) {
+				childCost[i] = newArea + inheritanceCost;
+			} else {
+				childCost[i] = (newArea - getAABBPerimeter(child->box)) + inheritanceCost;
+			}
+		}
+
+		if (cost < childCost[0] && cost < childCost[1]) {
+			break;
+		}
+		index = childCost[0] < childCost[1] ? children[0] : children[1];
+	}
+	int sibling = index;
+
+	int oldParent = tree->nodes[sibling].parent;
+	int newParent = allocateTreeNode(tree);
+	aabbTreeNode *nodes = tree->nodes; // allocating may have moved the nodes
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].box = combineAABB(leafBox, nodes[sibling].box);
+	nodes[newParent].height = nodes[sibling].height + 1;
+	nodes[newParent].child1 = sibling;
+	nodes[newParent].child2 = leaf;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+
+	if (oldParent != AABB_TREE_NULL) {
+		if (nodes[oldParent].child1 == sibling) {
+			nodes[oldParent].child1 = newParent;
+		} else {
+			nodes[oldParent].child2 = newParent;
+		}
+	} else {
+		tree->root = newParent;
+	}
+
+	refitTreeAncestors(tree, nodes[leaf].parent);
+}
+
+void removeTreeLeaf(aabbTree *tree, int leaf) {
+	if (leaf == tree->root) {
+		tree->root = AABB_TREE_NULL;
+		return;
+	}
+
+	aabbTreeNode *nodes = tree->nodes;
+	int parent = nodes[leaf].parent;
+	int grandParent = nodes[parent].parent;
+	int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+	if (grandParent != AABB_TREE_NULL) {
+		// destroy the parent and connect the sibling to the grandparent
+		if (nodes[grandParent].child1 == parent) {
+			nodes[grandParent].child1 = sibling;
+		} else {
+			nodes[grandParent].child2 = sibling;
+		}
+		nodes[sibling].parent = grandParent;
+		freeTreeNode(tree, parent);
+		refitTreeAncestors(tree, grandParent);
+	} else {
+		tree->root = sibling;
+		nodes[sibling].parent = AABB_TREE_NULL;
+		freeTreeNode(tree, parent);
+	}
+}
+
+// the tight box grown by the margin and stretched along the predicted motion
+AABB getFatAABB(AABB box, Vector2 velocity) {
+	AABB fat = box;
+	fat.min = vec2Sub(fat.min, (Vector2){AABB_TREE_MARGIN, AABB_TREE_MARGIN});
+	fat.max = vec2Add(fat.max, (Vector2){AABB_TREE_MARGIN, AABB_TREE_MARGIN});
+
+	Vector2 displacement = vec2Scale(velocity, AABB_TREE_PREDICTION);
+	if (displacement.x < 0.0f) {
+		fat.min.x += displacement.x;
+	} else {
+		fat.max.x += displacement.x;
+	}
+	if (displacement.y < 0.0f) {
+		fat.min.y += displacement.y;
+	} else {
+		fat.max.y += displacement.y;
+	}
+	return fat;
+}
+
+void markLeafMoved(aabbTree *tree, int leaf) {
+	if (tree->nodes[leaf].moved) {
+		return;
+	}
+	tree->nodes[leaf].moved = true;
+	tree->movedLeaves = growArray(tree->movedLeaves, &tree->moveCapacity, tree->moveCount + 1, sizeof(int));
+	tree->movedLeaves[tree->moveCount++] = leaf;
+}
+
+void addAABBTreeObject(aabbTree *tree, bodyPool *pool, int objectIndex) {
+	tree->leafOfObject = growArray(tree->leafOfObject, &tree->leafCapacity, tree->numObjects + 1, sizeof(int));
+	int leaf = allocateTreeNode(tree);
+	tree->nodes[leaf].objectIndex = objectIndex;
+	tree->nodes[leaf].box = getFatAABB(pool->box[objectIndex], pool->velocity[objectIndex]);
+	insertTreeLeaf(tree, leaf);
+	tree->leafOfObject[objectIndex] = leaf;
+	tree->numObjects++;
+	markLeafMoved(tree, leaf);
+}
+
+// takes the object's leaf out of the tree, then renames the object that was moved from lastIndex
+// into its place. the leaf and its pairs are dropped on the next update
+void removeAABBTreeObject(aabbTree *tree, int objectIndex, int lastIndex) {
+	int leaf = tree->leafOfObject[objectIndex];
+	removeTreeLeaf(tree, leaf);
+	tree->nodes[leaf].objectIndex = -1;
+	tree->removedLeaves = growArray(tree->removedLeaves, &tree->removedCapacity, tree->removedCount + 1, sizeof(int));
+	tree->removedLeaves[tree->removedCount++] = leaf;
+
+	if (objectIndex != lastIndex) {
+		int movedLeaf = tree->leafOfObject[lastIndex];
+		tree->leafOfObject[objectIndex] = movedLeaf;
+		tree->nodes[movedLeaf].objectIndex = objectIndex;
+	}
+	tree->numObjects--;
+}
+
+// reinserts every leaf whose object escaped its fat box and refreshes the pairs touching them,
+// then returns all of the overlapping pairs. only active bodies can have moved since the last
+// update, so the rest aren't even looked at
+pairList *updateAABBTree(aabbTree *tree, bodyPool *pool) {
+	for (int a = 0; a < pool->activeCount; a++) {
+		int i = pool->activeBodies[a];
+		int leaf = tree->leafOfObject[i];
+		if (AABBContains(&tree->nodes[leaf].box, &pool->box[i])) {
+			continue;
+		}
+		removeTreeLeaf(tree, leaf);
+		tree->nodes[leaf].box = getFatAABB(pool->box[i], pool->velocity[i]);
+		insertTreeLeaf(tree, leaf);
+		markLeafMoved(tree, leaf);
+	}
+
+	pairList *leafPairs = &tree->leafPairs;
+	if (tree->moveCount > 0 || tree->removedCount > 0) {
+		// drop the pairs involving a moved or removed leaf, the moved ones get found again below
+		int kept = 0;
+		for (int i = 0; i < leafPairs->count; i++) {
+			aabbTreeNode *leaf1 = &tree->nodes[leafPairs->pairs[i].index1];
+			aabbTreeNode *leaf2 = &tree->nodes[leafPairs->pairs[i].index2];
+			if (!leaf1->moved && !leaf2->moved && leaf1->objectIndex >= 0 && leaf2->objectIndex >= 0) {
+				leafPairs->pairs[kept++] = leafPairs->pairs[i];
+			}
+		}
+		leafPairs->count = kept;
+	}
+
+	for (int i = 0; i < tree->moveCount; i++) {
+		int queryLeaf = tree->movedLeaves[i];
+		int index1 = tree->nodes[queryLeaf].objectIndex;
+		// removed after it moved
+		if (index1 < 0) {
+			continue;
+		}
+		AABB queryBox = tree->nodes[queryLeaf].box;
+
+		int stackCount = 0;
+		tree->stack = growArray(tree->stack, &tree->stackCapacity, 1, sizeof(int));
+		tree->stack[stackCount++] = tree->root;
+		while (stackCount > 0) {
+			int nodeIndex = tree->stack[--stackCount];
+			aabbTreeNode *node = &tree->nodes[nodeIndex];
+			if (!AABBIntersect(&node->box, &queryBox)) {
+				continue;
+			}
+			if (!isTreeLeaf(node)) {
+				tree->stack = growArray(tree->stack, &tree->stackCapacity, stackCount + 2, sizeof(int));
+				tree->stack[stackCount++] = node->child1;
+				tree->stack[stackCount++] = node->child2;
+				continue;
+			}
+
+			if (nodeIndex == queryLeaf) {
+				continue;
+			}
+			// when both leaves moved, only the lower leaf reports the pair
+			if (node->moved && nodeIndex < queryLeaf) {
+				continue;
+			}
+			if (pool->objects[index1].isStaticBody && pool->objects[node->objectIndex].isStaticBody) {
+				continue;
+			}
+			addPair(leafPairs, queryLeaf, nodeIndex);
+		}
+	}
+
+	for (int i = 0; i < tree->moveCount; i++) {
+		tree->nodes[tree->movedLeaves[i]].moved = false;
+	}
+	tree->moveCount = 0;
+	for (int i = 0; i < tree->removedCount; i++) {
+		freeTreeNode(tree, tree->removedLeaves[i]);
+	}
+	tree->removedCount = 0;
+
+	pairList *pairs = &tree->pairs;
+	pairs->count = 0;
+	for (int i = 0; i < leafPairs->count; i++) {
+		addPair(pairs, tree->nodes[leafPairs->pairs[i].index1].objectIndex, tree->nodes[leafPairs->pairs[i].index2].objectIndex);
+	}
+	return pairs;
+}
+
+void freeAABBTree(aabbTree *tree) {
+	free(tree->nodes);
+	free(tree->leafOfObject);
+	free(tree->movedLeaves);
+	free(tree->removedLeaves);
+	free(tree->stack);
+	freePairList(&tree->leafPairs);
+	freePairList(&tree->pairs);
+	initAABBTree(tree);
+}
@@ -0,0 +1,131 @@
+// size of each chunk the arena grabs from malloc
+#define ARENA_BLOCK_SIZE (64 * 1024)
+// shapes with up to this many points get recycled through a free list when they're released
+#define SHAPE_SLAB_MAX_POINTS 64
+
+typedef struct arenaBlock {
+	struct arenaBlock *next;
+	size_t used;
+	size_t size;
+	max_align_t data[]; // keeps the first allocation suitably aligned
+} arenaBlock;
+
+// bump allocator.
+// allocations are packed one after the other in big blocks and can't be freed on their own,
+// only all at once with arenaReset() or freeArena()
+typedef struct {
+	arenaBlock *blocks; // the block being allocated from is first
+	arenaBlock *spareBlocks; // kept by arenaReset() for reuse
+} memoryArena;
+
+// where the next allocation with this alignment would start in the block
+size_t getArenaOffset(arenaBlock *block, size_t used, size_t alignment) {
+	uintptr_t start = (uintptr_t)block->data;
+	return ((start + used + alignment - 1) & ~(uintptr_t)(alignment - 1)) - start;
+}
+
+void *arenaAlloc(memoryArena *arena, size_t size, size_t alignment) {
+	arenaBlock *block = arena->blocks;
+	if (block != NULL) {
+		size_t offset = getArenaOffset(block, block->used, alignment);
+		if (offset + size <= block->size) {
+			block->used = offset + size;
+			return (char *)block->data + offset;
+		}
+	}
+
+	// start a new block, oversized allocations get a block of their own
+	size_t blockSize = size + alignment > ARENA_BLOCK_SIZE ? size + alignment : ARENA_BLOCK_SIZE;
+	if (arena->spareBlocks != NULL && arena->spareBlocks->size >= blockSize) {
+		block = arena->spareBlocks;
+		arena->spareBlocks = block->next;
+	} else {
+		block = (arenaBlock *)malloc(sizeof(arenaBlock) + blockSize);
+		if (block == NULL) {
+			fprintf(stderr, "shart2D: out of memory allocating an arena block\n");
+			exit(1);
+		}
+		block->size = blockSize;
+	}
+	size_t offset = getArenaOffset(block, 0, alignment);
+	block->used = offset + size;
+	block->next = arena->blocks;
+	arena->blocks = block;
+	return (char *)block->data + offset;
+}
+
+// throws away every allocation at once but keeps the memory around
+void arenaReset(memoryArena *arena) {
+	while (arena->blocks != NULL) {
+		arenaBlock *block = arena->blocks;
+		arena->blocks = block->next;
+		block->next = arena->spareBlocks;
+		arena->spareBlocks = block;
+	}
+}
+
+void freeArena(memoryArena *arena) {
+	arenaReset(arena);
+	while (arena->spareBlocks != NULL) {
+		arenaBlock *block = arena->spareBlocks;
+		arena->spareBlocks = block->next;
+		free(block);
+	}
+}
+
+// hands out collision shape instances with their header and world space points in one contiguous
+// piece of arena memory. released shapes are kept on a free list per point count, so
+// despawning and spawning bodies reuses the same memory instead of growing the arena
+typedef struct {
+	memoryArena arena;
+	polygonCollisionShape **freeShapes[SHAPE_SLAB_MAX_POINTS + 1];
+	int freeCount[SHAPE_SLAB_MAX_POINTS + 1];
+	int freeCapacity[SHAPE_SLAB_MAX_POINTS + 1];
+} shapeAllocator;
+
+polygonCollisionShape *allocatePolygonShape(shapeAllocator *allocator, const shapePrototype *prototype) {
+	int numPoints = prototype->numPoints;
+	polygonCollisionShape *shape;
+	if (numPoints <= SHAPE_SLAB_MAX_POINTS && allocator->freeCount[numPoints] > 0) {
+		shape = allocator->freeShapes[numPoints][--allocator->freeCount[numPoints]];
+	} else {
+		// header, points, normals, then the padded x and y arrays on SIMD boundaries
+		int paddedNumPoints = getPaddedPointCount(numPoints);
+		size_t pointsSize = (sizeof(polygonCollisionShape) + 2 * (size_t)numPoints * sizeof(Vector2) + SIMD_ALIGNMENT - 1) & ~(size_t)(SIMD_ALIGNMENT - 1);
+		size_t size = pointsSize + 2 * (size_t)paddedNumPoints * sizeof(float);
+		shape = arenaAlloc(&allocator->arena, size, SIMD_ALIGNMENT);
+		shape->numPoints = numPoints;
+		shape->paddedNumPoints = paddedNumPoints;
+		shape->globalPointArray = (Vector2 *)(shape + 1);
+		shape->globalEdgeNormals = shape->globalPointArray + numPoints;
+		shape->globalX = (float *)((char *)shape + pointsSize);
+		shape->globalY = shape->globalX + paddedNumPoints;
+	}
+	shape->type = prototype->type;
+	shape->radius = prototype->radius;
+	shape->pointArray = prototype->pointArray;
+	shape->prototype = prototype;
+	for (int i = 0; i < SUPPORT_CACHE_BUCKETS; i++) {
+		atomic_store_explicit(&shape->supportCache[i], -1, memory_order_relaxed);
+	}
+	return shape;
+}
+
+void releasePolygonShape(shapeAllocator *allocator, polygonCollisionShape *shape) {
+	int numPoints = shape->numPoints;
+	// bigger shapes stay in the arena until it's torn down
+	if (numPoints > SHAPE_SLAB_MAX_POINTS) {
+		return;
+	}
+	allocator->freeShapes[numPoints] = growArray(allocator->freeShapes[numPoints], &allocator->freeCapacity[numPoints], allocator->freeCount[numPoints] + 1, sizeof(polygonCollisionShape *));
+	allocator->freeShapes[numPoints][allocator->freeCount[numPoints]++] = shape;
+}
+
+// releases every shape at once
+void freeShapeAllocator(shapeAllocator *allocator) {
+	freeArena(&allocator->arena);
+	for (int i = 0; i <= SHAPE_SLAB_MAX_POINTS; i++) {
+		free(allocator->freeShapes[i]);
+	}
+	*allocator = (shapeAllocator){0};
+}
@@ -0,0 +1,305 @@
+#define NULL_BODY_SLOT -1
+// a body's id is its slot with the low bits of the slot's generation above it
+#define BODY_SLOT_BITS 24
+#define MAX_BODY_SLOTS (1 << BODY_SLOT_BITS)
+
+// refers to a body no matter where it currently sits in the pool.
+// the generation goes stale once the body is removed, so an old handle can't reach whatever
+// body reuses its slot
+typedef struct {
+	int slot;
+	int generation;
+} bodyHandle;
+
+typedef struct {
+	int denseIndex; // next free slot while the slot is on the free list
+	int generation;
+} bodySlot;
+
+// densely packed body storage, laid out as a structure of arrays.
+// the fields the simulation touches every substep each get their own aligned array, so the
+// integration and transform loops stream through memory linearly. everything else about a body
+// stays together in `objects`.
+// bodies always sit in [0, count). removal moves the last body into the hole, and handles go
+// through a slot table so they survive the move
+typedef struct {
+	// hot
+	Vector2 *position;
+	Vector2 *velocity;
+	float *rotation;
+	Vector2 *orientation; // (cos, sin) of rotation, only refreshed when rotation changes
+	float *angularVelocity;
+	float *invMass;
+	float *invInertia;
+	AABB *box;
+	// the world space points and box are stale and must be rebuilt before anything reads them
+	bool *transformDirty;
+	// static and sleeping bodies aren't awake, nothing simulates them
+	bool *awake;
+	float *sleepTime; // how long the body has been resting, see updateIslands
+	// where the body was when it started resting, slow bodies drag it along with them
+	Vector2 *restPosition;
+	float *restRotation;
+	int *islandId; // which sleeping island the body belongs to
+	// the slot of the next body in the same sleeping island. the island's bodies form a ring,
+	// so waking one of them can find the rest without looking at anything else
+	int *islandNext;
+	// where the body sits in activeBodies, -1 if it isn't on it
+	int *activePosition;
+	// every awake body, plus the ones that fell asleep or were moved by hand since the last
+	// pruneActiveBodies. integration, the transforms and the tree broadphase only look at these,
+	// so a settled pile costs nothing per substep. the order is whatever the wake ups and
+	// removals left it in, nothing that needs a fixed order may depend on it
+	int *activeBodies;
+	int activeCount;
+
+	// cold
+	physicsObject *objects;
+	int *denseToSlot;
+
+	int count;
+	int capacity;
+
+	bodySlot *slots;
+	int slotCount;
+	int slotCapacity;
+	int freeSlot;
+} bodyPool;
+
+void reserveBodies(bodyPool *pool, int needed) {
+	if (needed <= pool->capacity) {
+		return;
+	}
+	int capacity = pool->capacity > 0 ? pool->capacity : 16;
+	while (capacity < needed) {
+		capacity *= 2;
+	}
+	int count = pool->count;
+	pool->position = reallocAligned(pool->position, count, capacity, sizeof(Vector2));
+	pool->velocity = reallocAligned(pool->velocity, count, capacity, sizeof(Vector2));
+	pool->rotation = reallocAligned(pool->rotation, count, capacity, sizeof(float));
+	pool->orientation = reallocAligned(pool->orientation, count, capacity, sizeof(Vector2));
+	pool->angularVelocity = reallocAligned(pool->angularVelocity, count, capacity, sizeof(float));
+	pool->invMass = reallocAligned(pool->invMass, count, capacity, sizeof(float));
+	pool->invInertia = reallocAligned(pool->invInertia, count, capacity, sizeof(float));
+	pool->box = reallocAligned(pool->box, count, capacity, sizeof(AABB));
+	pool->transformDirty = reallocAligned(pool->transformDirty, count, capacity, sizeof(bool));
+	pool->awake = reallocAligned(pool->awake, count, capacity, sizeof(bool));
+	pool->sleepTime = reallocAligned(pool->sleepTime, count, capacity, sizeof(float));
+	pool->restPosition = reallocAligned(pool->restPosition, count, capacity, sizeof(Vector2));
+	pool->restRotation = reallocAligned(pool->restRotation, count, capacity, sizeof(float));
+	pool->islandId = reallocAligned(pool->islandId, count, capacity, sizeof(int));
+	pool->islandNext = reallocAligned(pool->islandNext, count, capacity, sizeof(int));
+	pool->activePosition = reallocAligned(pool->activePosition, count, capacity, sizeof(int));
+	pool->activeBodies = reallocAligned(pool->activeBodies, pool->activeCount, capacity, sizeof(int));
+	pool->objects = reallocAligned(pool->objects, count, capacity, sizeof(physicsObject));
+	pool->denseToSlot = reallocAligned(pool->denseToSlot, count, capacity, sizeof(int));
+	pool->capacity = capacity;
+}
+
+// adds a body at rest and not awake, the caller fills in the rest of its hot fields through the returned handle
+bodyHandle addBody(bodyPool *pool, physicsObject object) {
+	int slot = pool->freeSlot;
+	if (slot != NULL_BODY_SLOT) {
+		pool->freeSlot = pool->slots[slot].denseIndex;
+	} else {
+		if (pool->slotCount == MAX_BODY_SLOTS) {
+			fprintf(stderr, "shart2D: more than %d bodies at once\n", MAX_BODY_SLOTS);
+			exit(1);
+		}
+		pool->slots = growArray(pool->slots, &pool->slotCapacity, pool->slotCount + 1, sizeof(bodySlot));
+		slot = pool->slotCount++;
+		pool->slots[slot].generation = 0;
+	}
+
+	reserveBodies(pool, pool->count + 1);
+	int index = pool->count++;
+	pool->position[index] = (Vector2){0, 0};
+	pool->velocity[index] = (Vector2){0, 0};
+	pool->rotation[index] = 0.0f;
+	pool->orientation[index] = (Vector2){1.0f, 0.0f};
+	pool->angularVelocity[index] = 0.0f;
+	pool->invMass[index] = 0.0f;
+	pool->invInertia[index] = 0.0f;
+	pool->box[index] = (AABB){(Vector2){0, 0}, (Vector2){0, 0}};
+	pool->transformDirty[index] = true;
+	pool->awake[index] = false;
+	pool->sleepTime[index] = 0.0f;
+	pool->restPosition[index] = (Vector2){0, 0};
+	pool->restRotation[index] = 0.0f;
+	pool->islandId[index] = -1;
+	pool->islandNext[index] = NULL_BODY_SLOT;
+	pool->activePosition[index] = -1;
+	pool->objects[index] = object;
+	pool->denseToSlot[index] = slot;
+	pool->slots[slot].denseIndex = index;
+
+	return (bodyHandle){slot, pool->slots[slot].generation};
+}
+
+// puts the body on the active list, if it isn't on it already
+void activateBody(bodyPool *pool, int index) {
+	if (pool->activePosition[index] >= 0) {
+		return;
+	}
+	pool->activePosition[index] = pool->activeCount;
+	pool->activeBodies[pool->activeCount++] = index;
+}
+
+void deactivateBody(bodyPool *pool, int index) {
+	int position = pool->activePosition[index];
+	int last = pool->activeBodies[--pool->activeCount];
+	pool->activeBodies[position] = last;
+	pool->activePosition[last] = position;
+	pool->activePosition[index] = -1;
+}
+
+// a body that falls asleep stays active until pruneActiveBodies, its transform still has to be
+// rebuilt one last time for the broadphase
+void setBodyAwake(bodyPool *pool, int index, bool awake) {
+	pool->awake[index] = awake;
+	if (awake) {
+		activateBody(pool, index);
+	}
+}
+
+// drops everything that isn't awake from the active list, call once the broadphase has seen
+// where those bodies ended up
+void pruneActiveBodies(bodyPool *pool) {
+	for (int i = 0; i < pool->activeCount; i++) {
+		int index = pool->activeBodies[i];
+		if (!pool->awake[index]) {
+			// the last one takes its place, look at this position again
+			deactivateBody(pool, index);
+			i--;
+		}
+	}
+}
+
+void setBodyRotation(bodyPool *pool, int index, float rotation) {
+	pool->rotation[index] = rotation;
+	pool->orientation[index] = (Vector2){cosf(rotation), sinf(rotation)};
+}
+
+// where the body currently sits in the pool, or -1 if the handle is stale
+int getBodyIndex(bodyPool *pool, bodyHandle handle) {
+	if (handle.slot < 0 || handle.slot >= pool->slotCount) {
+		return -1;
+	}
+	bodySlot *slot = &pool->slots[handle.slot];
+	if (slot->generation != handle.generation) {
+		return -1;
+	}
+	return slot->denseIndex;
+}
+
+bodyHandle getBodyHandle(bodyPool *pool, int index) {
+	int slot = pool->denseToSlot[index];
+	return (bodyHandle){slot, pool->slots[slot].generation};
+}
+
+// names the body in anything kept from one step to the next, like the separating axis cache and
+// the warm starting manifolds. unlike the slot alone, a new body that reuses the slot gets a
+// different id, so it can't pick up what the last one left behind. the generation wraps after
+// 256 reuses, and nothing is kept around for that long
+unsigned int getBodyId(bodyPool *pool, int index) {
+	int slot = pool->denseToSlot[index];
+	return ((unsigned int)pool->slots[slot].generation << BODY_SLOT_BITS) | (unsigned int)slot;
+}
+
+// removes the body and moves the last body into its place.
+// anything indexing the dense arrays has to be told about the move before this is called
+bool removeBody(bodyPool *pool, bodyHandle handle) {
+	int index = getBodyIndex(pool, handle);
+	if (index < 0) {
+		return false;
+	}
+
+	if (pool->activePosition[index] >= 0) {
+		deactivateBody(pool, index);
+	}
+	int lastIndex = --pool->count;
+	if (index != lastIndex) {
+		pool->position[index] = pool->position[lastIndex];
+		pool->velocity[index] = pool->velocity[lastIndex];
+		pool->rotation[index] = pool->rotation[lastIndex];
+		pool->orientation[index] = pool->orientation[lastIndex];
+		pool->angularVelocity[index] = pool->angularVelocity[lastIndex];
+		pool->invMass[index] = pool->invMass[lastIndex];
+		pool->invInertia[index] = pool->invInertia[lastIndex];
+		pool->box[index] = pool->box[lastIndex];
+		pool->transformDirty[index] = pool->transformDirty[lastIndex];
+		pool->awake[index] = pool->awake[lastIndex];
+		pool->sleepTime[index] = pool->sleepTime[lastIndex];
+		pool->restPosition[index] = pool->restPosition[lastIndex];
+		pool->restRotation[index] = pool->restRotation[lastIndex];
+		pool->islandId[index] = pool->islandId[lastIndex];
+		pool->islandNext[index] = pool->islandNext[lastIndex];
+		pool->activePosition[index] = pool->activePosition[lastIndex];
+		if (pool->activePosition[index] >= 0) {
+			pool->activeBodies[pool->activePosition[index]] = index;
+		}
+		pool->objects[index] = pool->objects[lastIndex];
+		pool->denseToSlot[index] = pool->denseToSlot[lastIndex];
+		pool->slots[pool->denseToSlot[index]].denseIndex = index;
+	}
+
+	bodySlot *slot = &pool->slots[handle.slot];
+	slot->generation++;
+	slot->denseIndex = pool->freeSlot;
+	pool->freeSlot = handle.slot;
+	return true;
+}
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+// FNV-1a
+unsigned long long hashBytes(unsigned long long hash, const void *data, size_t size) {
+	const unsigned char *bytes = data;
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ bytes[i]) * FNV_PRIME;
+	}
+	return hash;
+}
+
+// hashes everything the next step starts from, bit for bit and in pool order, so two
+// simulations that agree on it are in exactly the same state
+unsigned long long hashBodyPool(bodyPool *pool) {
+	size_t count = pool->count;
+	unsigned long long hash = FNV_OFFSET_BASIS;
+	hash = hashBytes(hash, pool->position, count * sizeof(Vector2));
+	hash = hashBytes(hash, pool->velocity, count * sizeof(Vector2));
+	hash = hashBytes(hash, pool->rotation, count * sizeof(float));
+	hash = hashBytes(hash, pool->angularVelocity, count * sizeof(float));
+	hash = hashBytes(hash, pool->awake, count * sizeof(bool));
+	hash = hashBytes(hash, pool->sleepTime, count * sizeof(float));
+	hash = hashBytes(hash, pool->restPosition, count * sizeof(Vector2));
+	hash = hashBytes(hash, pool->restRotation, count * sizeof(float));
+	return hash;
+}
+
+void freeBodyPool(bodyPool *pool) {
+	free(pool->position);
+	free(pool->velocity);
+	free(pool->rotation);
+	free(pool->orientation);
+	free(pool->angularVelocity);
+	free(pool->invMass);
+	free(pool->invInertia);
+	free(pool->box);
+	free(pool->transformDirty);
+	free(pool->awake);
+	free(pool->sleepTime);
+	free(pool->restPosition);
+	free(pool->restRotation);
+	free(pool->islandId);
+	free(pool->islandNext);
+	free(pool->activePosition);
+	free(pool->activeBodies);
+	free(pool->objects);
+	free(pool->denseToSlot);
+	free(pool->slots);
+	*pool = (bodyPool){0};
+	pool->freeSlot = NULL_BODY_SLOT;
+}
@@ -0,0 +1,272 @@
+typedef enum {
+	BROADPHASE_SWEEP_AND_PRUNE,
+	BROADPHASE_AABB_TREE,
+	BROADPHASE_HIERARCHICAL_GRID,
+} broadphaseType;
+
+// a pair of objects whose AABBs overlap, handed to the narrowphase
+typedef struct {
+	int index1;
+	int index2;
+} broadphasePair;
+
+typedef struct {
+	broadphasePair *pairs;
+	int count;
+	int capacity;
+} pairList;
+
+void addPair(pairList *list, int index1, int index2) {
+	list->pairs = growArray(list->pairs, &list->capacity, list->count + 1, sizeof(broadphasePair));
+	// always store the lower index first so a pair has exactly one representation
+	if (index1 > index2) {
+		int temp = index1;
+		index1 = index2;
+		index2 = temp;
+	}
+	list->pairs[list->count++] = (broadphasePair){index1, index2};
+}
+
+int comparePairs(const void *a, const void *b) {
+	const broadphasePair *pair1 = a;
+	const broadphasePair *pair2 = b;
+	if (pair1->index1 != pair2->index1) {
+		return (pair1->index1 > pair2->index1) - (pair1->index1 < pair2->index1);
+	}
+	return (pair1->index2 > pair2->index2) - (pair1->index2 < pair2->index2);
+}
+
+// puts the pairs in index order, whatever order the broadphase found them in
+void sortPairs(pairList *list) {
+	if (list->count > 1) {
+		qsort(list->pairs, list->count, sizeof(broadphasePair), comparePairs);
+	}
+}
+
+void freePairList(pairList *list) {
+	free(list->pairs);
+	*list = (pairList){0};
+}
+
+// more objects than this added since the last update and the endpoints get sorted from scratch.
+// new endpoints start at the end of the array, and insertion sort would walk every one of them
+// across the whole thing
+#define SWEEP_RESORT_THRESHOLD 16
+
+// one end of an AABB projected onto an axis
+typedef struct {
+	float value;
+	int proxy;
+	bool isMin;
+} sweepEndpoint;
+
+// sort-and-sweep broadphase.
+// the endpoints of every AABB are kept sorted along both axes. objects barely move between
+// substeps so the lists stay almost sorted, and insertion sort fixes them up in close to O(n).
+// endpoints name a proxy instead of the object, so the object can move around in the pool
+// without anything in the sorted lists changing. removing an object only marks its proxy dead,
+// the next update drops its endpoints
+typedef struct {
+	sweepEndpoint *endpoints[2]; // [0] is x, [1] is y
+	int endpointCapacity[2];
+	int numEndpoints;
+	int numObjects;
+
+	int *proxyOfObject;
+	int proxyOfObjectCapacity;
+	int *objectOfProxy; // -1 once the object is removed
+	int objectOfProxyCapacity;
+	int proxyCount;
+	int *freeProxies;
+	int freeProxyCount;
+	int freeProxyCapacity;
+
+	// objects whose min endpoint has been passed but not their max endpoint yet
+	int *activeList;
+	int activeCapacity;
+	// where each object sits in activeList, so removal is O(1)
+	int *activePosition;
+	int positionCapacity;
+	int addedSinceUpdate;
+	int removedSinceUpdate;
+} sweepAndPrune;
+
+float getAxisValue(Vector2 v, int axis) {
+	return axis == 0 ? v.x : v.y;
+}
+
+bool endpointLess(sweepEndpoint *a, sweepEndpoint *b) {
+	if (a->value != b->value) {
+		return a->value < b->value;
+	}
+	// min before max, so touching boxes still count as overlapping (same as AABBIntersect)
+	return a->isMin && !b->isMin;
+}
+
+int compareEndpoints(const void *a, const void *b) {
+	sweepEndpoint *endpoint1 = (sweepEndpoint *)a;
+	sweepEndpoint *endpoint2 = (sweepEndpoint *)b;
+	return endpointLess(endpoint1, endpoint2) ? -1 : endpointLess(endpoint2, endpoint1);
+}
+
+void insertionSortEndpoints(sweepEndpoint *endpoints, int count) {
+	for (int i = 1; i < count; i++) {
+		sweepEndpoint key = endpoints[i];
+		int j = i - 1;
+		while (j >= 0 && endpointLess(&key, &endpoints[j])) {
+			endpoints[j + 1] = endpoints[j];
+			j--;
+		}
+		endpoints[j + 1] = key;
+	}
+}
+
+// new endpoints go on the end, the next update sorts them into place
+void addSweepAndPruneObject(sweepAndPrune *sap, int objectIndex) {
+	int proxy;
+	if (sap->freeProxyCount > 0) {
+		proxy = sap->freeProxies[--sap->freeProxyCount];
+	} else {
+		proxy = sap->proxyCount++;
+		sap->objectOfProxy = growArray(sap->objectOfProxy, &sap->objectOfProxyCapacity, sap->proxyCount, sizeof(int));
+	}
+	sap->objectOfProxy[proxy] = objectIndex;
+	sap->proxyOfObject = growArray(sap->proxyOfObject, &sap->proxyOfObjectCapacity, objectIndex + 1, sizeof(int));
+	sap->proxyOfObject[objectIndex] = proxy;
+
+	for (int axis = 0; axis < 2; axis++) {
+		sap->endpoints[axis] = growArray(sap->endpoints[axis], &sap->endpointCapacity[axis], sap->numEndpoints + 2, sizeof(sweepEndpoint));
+		sap->endpoints[axis][sap->numEndpoints] = (sweepEndpoint){0.0f, proxy, true};
+		sap->endpoints[axis][sap->numEndpoints + 1] = (sweepEndpoint){0.0f, proxy, false};
+	}
+	sap->numEndpoints += 2;
+	sap->numObjects++;
+	sap->addedSinceUpdate++;
+}
+
+// kills the object's proxy and hands the proxy of the object that was moved from lastIndex
+// over to its new index. the endpoints stay where they are until the next update
+void removeSweepAndPruneObject(sweepAndPrune *sap, int objectIndex, int lastIndex) {
+	sap->objectOfProxy[sap->proxyOfObject[objectIndex]] = -1;
+	if (objectIndex != lastIndex) {
+		int movedProxy = sap->proxyOfObject[lastIndex];
+		sap->proxyOfObject[objectIndex] = movedProxy;
+		sap->objectOfProxy[movedProxy] = objectIndex;
+	}
+	sap->numObjects--;
+	sap->removedSinceUpdate++;
+}
+
+// drops the endpoints of removed objects and frees their proxies
+void compactSweepAndPrune(sweepAndPrune *sap) {
+	for (int axis = 0; axis < 2; axis++) {
+		sweepEndpoint *endpoints = sap->endpoints[axis];
+		int kept = 0;
+		for (int i = 0; i < sap->numEndpoints; i++) {
+			int proxy = endpoints[i].proxy;
+			if (sap->objectOfProxy[proxy] >= 0) {
+				endpoints[kept++] = endpoints[i];
+			} else if (axis == 0 && endpoints[i].isMin) {
+				sap->freeProxies = growArray(sap->freeProxies, &sap->freeProxyCapacity, sap->freeProxyCount + 1, sizeof(int));
+				sap->freeProxies[sap->freeProxyCount++] = proxy;
+			}
+		}
+	}
+	sap->numEndpoints = sap->numObjects * 2;
+}
+
+// refreshes every endpoint from the current boxes and re-sorts them.
+// unlike the tree this still looks at sleeping bodies. the insertion sort and the sweep have to
+// pass over every endpoint anyway, awake bodies can still run into sleeping ones, so reading
+// the box on the way past is next to free. for worlds that are mostly asleep use the tree
+void updateSweepAndPrune(sweepAndPrune *sap, bodyPool *pool) {
+	if (sap->removedSinceUpdate > 0) {
+		compactSweepAndPrune(sap);
+	}
+	int numEndpoints = sap->numEndpoints;
+	for (int axis = 0; axis < 2; axis++) {
+		sweepEndpoint *endpoints = sap->endpoints[axis];
+		for (int i = 0; i < numEndpoints; i++) {
+			AABB *box = &pool->box[sap->objectOfProxy[endpoints[i].proxy]];
+			endpoints[i].value = getAxisValue(endpoints[i].isMin ? box->min : box->max, axis);
+		}
+		if (sap->addedSinceUpdate > SWEEP_RESORT_THRESHOLD) {
+			qsort(endpoints, numEndpoints, sizeof(sweepEndpoint), compareEndpoints);
+		} else {
+			insertionSortEndpoints(endpoints, numEndpoints);
+		}
+	}
+	sap->addedSinceUpdate = 0;
+	sap->removedSinceUpdate = 0;
+}
+
+// sweeps along whichever axis the objects are most spread out on, and writes every overlapping
+// pair that has at least one awake body into `pairs`
+void findSweepAndPrunePairs(sweepAndPrune *sap, bodyPool *pool, pairList *pairs) {
+	pairs->count = 0;
+	if (sap->numObjects == 0) {
+		return;
+	}
+
+	// pick the sweep axis by the variance of the box centers
+	float sum[2] = {0.0f, 0.0f};
+	float sumSquared[2] = {0.0f, 0.0f};
+	for (int i = 0; i < sap->numObjects; i++) {
+		AABB *box = &pool->box[i];
+		Vector2 center = vec2Scale(vec2Add(box->min, box->max), 0.5f);
+		sum[0] += center.x;
+		sum[1] += center.y;
+		sumSquared[0] += center.x * center.x;
+		sumSquared[1] += center.y * center.y;
+	}
+	float variance[2];
+	for (int axis = 0; axis < 2; axis++) {
+		variance[axis] = sumSquared[axis] - (sum[axis] * sum[axis]) / (float)sap->numObjects;
+	}
+	int sweepAxis = variance[1] > variance[0] ? 1 : 0;
+	int otherAxis = 1 - sweepAxis;
+
+	sap->activeList = growArray(sap->activeList, &sap->activeCapacity, sap->numObjects, sizeof(int));
+	sap->activePosition = growArray(sap->activePosition, &sap->positionCapacity, sap->numObjects, sizeof(int));
+	int activeCount = 0;
+
+	sweepEndpoint *endpoints = sap->endpoints[sweepAxis];
+	for (int i = 0; i < sap->numEndpoints; i++) {
+		int index1 = sap->objectOfProxy[endpoints[i].proxy];
+		if (!endpoints[i].isMin) {
+			// swap-remove from the active list
+			int position = sap->activePosition[index1];
+			int last = sap->activeList[--activeCount];
+			sap->activeList[position] = last;
+			sap->activePosition[last] = position;
+			continue;
+		}
+
+		AABB *box1 = &pool->box[index1];
+		for (int j = 0; j < activeCount; j++) {
+			int index2 = sap->activeList[j];
+			if (!pool->awake[index1] && !pool->awake[index2]) {
+				continue;
+			}
+			// already overlapping on the sweep axis, so only the other axis needs checking
+			AABB *box2 = &pool->box[index2];
+			if (getAxisValue(box1->min, otherAxis) <= getAxisValue(box2->max, otherAxis) &&
+					getAxisValue(box1->max, otherAxis) >= getAxisValue(box2->min, otherAxis)) {
+				addPair(pairs, index1, index2);
+			}
+		}
+		sap->activePosition[index1] = activeCount;
+		sap->activeList[activeCount++] = index1;
+	}
+}
+
+void freeSweepAndPrune(sweepAndPrune *sap) {
+	free(sap->endpoints[0]);
+	free(sap->endpoints[1]);
+	free(sap->proxyOfObject);
+	free(sap->objectOfProxy);
+	free(sap->freeProxies);
+	free(sap->activeList);
+	free(sap->activePosition);
+	*sap = (sweepAndPrune){0};
+}
@@ -0,0 +1,446 @@
+// cores closer than this are treated as touching, and round shapes against polygons switch from
+// closest points to face clipping
+#define ROUND_CORE_SLOP 0.005f
+// how closely the direction between the closest points has to follow the best face normal
+// for the face to be used instead of a single corner contact
+#define ROUND_FACE_ALIGNMENT 0.999f
+
+collisionResult emptyCollisionResult() {
+	collisionResult result = {0};
+	result.body1 = -1;
+	result.body2 = -1;
+	return result;
+}
+
+// closest points between the segments p1-q1 and p2-q2, either of which may be a single point
+void closestPointsOnSegments(Vector2 p1, Vector2 q1, Vector2 p2, Vector2 q2, Vector2 *closest1, Vector2 *closest2) {
+	Vector2 direction1 = vec2Sub(q1, p1);
+	Vector2 direction2 = vec2Sub(q2, p2);
+	Vector2 offset = vec2Sub(p1, p2);
+	float length1 = vec2Dot(direction1, direction1);
+	float length2 = vec2Dot(direction2, direction2);
+	float along2 = vec2Dot(direction2, offset);
+	float s = 0.0f;
+	float t = 0.0f;
+
+	if (length1 <= FLT_EPSILON && length2 <= FLT_EPSILON) {
+		// both are points
+	} else if (length1 <= FLT_EPSILON) {
+		t = fmaxf(0.0f, fminf(1.0f, along2 / length2));
+	} else {
+		float along1 = vec2Dot(direction1, offset);
+		if (length2 <= FLT_EPSILON) {
+			s = fmaxf(0.0f, fminf(1.0f, -along1 / length1));
+		} else {
+			float cosine = vec2Dot(direction1, direction2);
+			float denominator = length1 * length2 - cosine * cosine;
+			// parallel segments can use any point, the start is as good as any
+			s = denominator != 0.0f ? fmaxf(0.0f, fminf(1.0f, (cosine * along2 - along1 * length2) / denominator)) : 0.0f;
+			t = (cosine * s + along2) / length2;
+			if (t < 0.0f) {
+				t = 0.0f;
+				s = fmaxf(0.0f, fminf(1.0f, -along1 / length1));
+			} else if (t > 1.0f) {
+				t = 1.0f;
+				s = fmaxf(0.0f, fminf(1.0f, (cosine - along1) / length1));
+			}
+		}
+	}
+	*closest1 = vec2Add(p1, vec2Scale(direction1, s));
+	*closest2 = vec2Add(p2, vec2Scale(direction2, t));
+}
+
+// one contact between two round things, given the closest points of their cores.
+// `fallbackNormal` (pointing from 1 to 2) is used when the cores cross and the points meet
+collisionResult makeRoundContact(Vector2 closest1, float radius1, Vector2 closest2, float radius2, Vector2 fallbackNormal) {
+	collisionResult result = emptyCollisionResult();
+	Vector2 difference = vec2Sub(closest2, closest1);
+	float distanceSquared = vec2LengthSquared(difference);
+	float radius = radius1 + radius2;
+	if (distanceSquared >= radius * radius) {
+		return result;
+	}
+	float distance = sqrtf(distanceSquared);
+	Vector2 normal = distance > 0.0f ? vec2Scale(difference, 1.0f / distance) : fallbackNormal;
+
+	result.isCollided = true;
+	result.penetrationDepth = radius - distance;
+	// halfway between the two surfaces
+	Vector2 surface1 = vec2Add(closest1, vec2Scale(normal, radius1));
+	Vector2 surface2 = vec2Sub(closest2, vec2Scale(normal, radius2));
+	result.contact1 = vec2Scale(vec2Add(surface1, surface2), 0.5f);
+	result.depth1 = result.penetrationDepth;
+	result.numContacts = 1;
+	// the caller pushes body1 along the normal
+	result.normal = vec2Negate(normal);
+	return result;
+}
+
+collisionResult collideCircles(polygonCollisionShape *circle1, polygonCollisionShape *circle2, separatingAxis *cachedAxis) {
+	return makeRoundContact(circle1->globalPointArray[0], circle1->radius, circle2->globalPointArray[0], circle2->radius, (Vector2){0.0f, 1.0f});
+}
+
+collisionResult collideCircleCapsule(polygonCollisionShape *circle, polygonCollisionShape *capsule, separatingAxis *cachedAxis) {
+	Vector2 center = circle->globalPointArray[0];
+	Vector2 closestCircle, closestCapsule;
+	closestPointsOnSegments(center, center, capsule->globalPointArray[0], capsule->globalPointArray[1], &closestCircle, &closestCapsule);
+	return makeRoundContact(closestCircle, circle->radius, closestCapsule, capsule->radius, vec2Negate(capsule->globalEdgeNormals[0]));
+}
+
+// a single contact, so two parallel capsules resting on each other rock a little
+collisionResult collideCapsules(polygonCollisionShape *capsule1, polygonCollisionShape *capsule2, separatingAxis *cachedAxis) {
+	Vector2 closest1, closest2;
+	closestPointsOnSegments(capsule1->globalPointArray[0], capsule1->globalPointArray[1], capsule2->globalPointArray[0], capsule2->globalPointArray[1], &closest1, &closest2);
+	return makeRoundContact(closest1, capsule1->radius, closest2, capsule2->radius, capsule1->globalEdgeNormals[0]);
+}
+
+collisionResult collidePolygonCircle(polygonCollisionShape *polygon, polygonCollisionShape *circle, separatingAxis *cachedAxis) {
+	Vector2 *points = polygon->globalPointArray;
+	int numPoints = polygon->numPoints;
+	Vector2 center = circle->globalPointArray[0];
+	float radius = circle->radius;
+
+	// the face the center is furthest in front of
+	int bestEdge = 0;
+	float bestSeparation = -INFINITY;
+	for (int i = 0; i < numPoints; i++) {
+		float separation = vec2Dot(polygon->globalEdgeNormals[i], vec2Sub(center, points[i]));
+		if (separation > radius) {
+			return emptyCollisionResult();
+		}
+		if (separation > bestSeparation) {
+			bestSeparation = separation;
+			bestEdge = i;
+		}
+	}
+
+	Vector2 point1 = points[bestEdge];
+	Vector2 point2 = points[(bestEdge + 1) % numPoints];
+	collisionResult result;
+	if (bestSeparation <= 0.0f) {
+		// the center is inside, push it out through that face
+		Vector2 normal = polygon->globalEdgeNormals[bestEdge];
+		result = emptyCollisionResult();
+		result.isCollided = true;
+		result.penetrationDepth = radius - bestSeparation;
+		result.contact1 = vec2Sub(center, vec2Scale(normal, bestSeparation));
+		result.depth1 = result.penetrationDepth;
+		result.numContacts = 1;
+		result.normal = vec2Negate(normal);
+	} else {
+		// outside, the closest point is on that face or one of its corners
+		Vector2 closestPolygon, closestCircle;
+		closestPointsOnSegments(point1, point2, center, center, &closestPolygon, &closestCircle);
+		result = makeRoundContact(closestPolygon, 0.0f, closestCircle, radius, polygon->globalEdgeNormals[bestEdge]);
+	}
+	result.feature1 = makeContactFeature(1, 0, bestEdge);
+	return result;
+}
+
+// keeps the deeper of the clipped points, moved onto the reference face
+void addClippedRoundContacts(collisionResult *result, Vector2 *clipped, contactFeature *clippedFeatures,
+		Vector2 referenceNormal, Vector2 referencePoint, float radius, bool moveOntoFace) {
+	Vector2 *contacts[2] = {&result->contact1, &result->contact2};
+	contactFeature *features[2] = {&result->feature1, &result->feature2};
+	float *depths[2] = {&result->depth1, &result->depth2};
+	for (int i = 0; i < 2; i++) {
+		float distance = vec2Dot(referenceNormal, vec2Sub(clipped[i], referencePoint));
+		float separation = distance - radius;
+		if (separation > 0.0f) {
+			continue;
+		}
+		*contacts[result->numContacts] = moveOntoFace ? vec2Sub(clipped[i], vec2Scale(referenceNormal, distance)) : clipped[i];
+		*features[result->numContacts] = clippedFeatures[i];
+		*depths[result->numContacts] = -separation;
+		result->numContacts++;
+		if (-separation > result->penetrationDepth) {
+			result->penetrationDepth = -separation;
+		}
+	}
+}
+
+// a capsule is treated as a two point polygon grown by its radius: SAT finds the best face of
+// either shape, then the other shape's edge is clipped against it, same as two polygons.
+// when the cores are apart and the closest points sit off to the side of that face, it's a
+// corner touching the cap and gets a single contact instead
+collisionResult collidePolygonCapsule(polygonCollisionShape *polygon, polygonCollisionShape *capsule, separatingAxis *cachedAxis) {
+	Vector2 *points = polygon->globalPointArray;
+	int numPoints = polygon->numPoints;
+	Vector2 capsulePoints[2] = {capsule->globalPointArray[0], capsule->globalPointArray[1]};
+	float radius = capsule->radius;
+
+	int polygonEdge = 0;
+	float polygonSeparation = -INFINITY;
+	for (int i = 0; i < numPoints; i++) {
+		Vector2 normal = polygon->globalEdgeNormals[i];
+		float separation = fminf(vec2Dot(normal, vec2Sub(capsulePoints[0], points[i])), vec2Dot(normal, vec2Sub(capsulePoints[1], points[i])));
+		if (separation > radius) {
+			return emptyCollisionResult();
+		}
+		if (separation > polygonSeparation) {
+			polygonSeparation = separation;
+			polygonEdge = i;
+		}
+	}
+
+	// the capsule's two sides
+	int capsuleSide = 0;
+	float capsuleSeparation = -INFINITY;
+	for (int side = 0; side < 2; side++) {
+		Vector2 normal = capsule->globalEdgeNormals[side];
+		float separation = INFINITY;
+		for (int i = 0; i < numPoints; i++) {
+			separation = fminf(separation, vec2Dot(normal, vec2Sub(points[i], capsulePoints[0])));
+		}
+		if (separation > radius) {
+			return emptyCollisionResult();
+		}
+		if (separation > capsuleSeparation) {
+			capsuleSeparation = separation;
+			capsuleSide = side;
+		}
+	}
+
+	bool polygonReference = polygonSeparation >= capsuleSeparation - REFERENCE_FACE_TOLERANCE;
+	// pointing from the polygon to the capsule
+	Vector2 faceNormal = polygonReference ? polygon->globalEdgeNormals[polygonEdge] : vec2Negate(capsule->globalEdgeNormals[capsuleSide]);
+
+	// when the cores are apart, how far apart they really are. the face only sees how far things
+	// are in front of its own plane, which is too deep for anything off to the side of it
+	bool coresApart = fmaxf(polygonSeparation, capsuleSeparation) > ROUND_CORE_SLOP;
+	float coreDistance = 0.0f;
+	Vector2 closestPolygon = points[0];
+	Vector2 closestCapsule = capsulePoints[0];
+	if (coresApart) {
+		float bestDistanceSquared = INFINITY;
+		for (int i = 0; i < numPoints; i++) {
+			Vector2 polygonPoint, capsulePoint;
+			closestPointsOnSegments(points[i], points[(i + 1) % numPoints], capsulePoints[0], capsulePoints[1], &polygonPoint, &capsulePoint);
+			float distanceSquared = vec2DistSquared(polygonPoint, capsulePoint);
+			if (distanceSquared < bestDistanceSquared) {
+				bestDistanceSquared = distanceSquared;
+				closestPolygon = polygonPoint;
+				closestCapsule = capsulePoint;
+			}
+		}
+		if (bestDistanceSquared >= radius * radius) {
+			return emptyCollisionResult();
+		}
+		coreDistance = sqrtf(bestDistanceSquared);
+		Vector2 closestNormal = vec2Scale(vec2Sub(closestCapsule, closestPolygon), 1.0f / coreDistance);
+		if (vec2Dot(closestNormal, faceNormal) < ROUND_FACE_ALIGNMENT) {
+			return makeRoundContact(closestPolygon, 0.0f, closestCapsule, radius, faceNormal);
+		}
+	}
+
+	collisionResult result = emptyCollisionResult();
+	Vector2 clipped1[2], clipped2[2];
+	contactFeature clippedFeatures1[2], clippedFeatures2[2];
+	if (polygonReference) {
+		Vector2 referencePoint1 = points[polygonEdge];
+		Vector2 referencePoint2 = points[(polygonEdge + 1) % numPoints];
+		Vector2 tangent = vec2Sub(referencePoint2, referencePoint1);
+		contactFeature incidentFeatures[2] = {makeContactFeature(1, 0, polygonEdge), makeContactFeature(1, 1, polygonEdge)};
+		if (clipSegmentToLine(clipped1, clippedFeatures1, capsulePoints, incidentFeatures, vec2Negate(tangent), -vec2Dot(tangent, referencePoint1)) == 2 &&
+				clipSegmentToLine(clipped2, clippedFeatures2, clipped1, clippedFeatures1, tangent, vec2Dot(tangent, referencePoint2)) == 2) {
+			addClippedRoundContacts(&result, clipped2, clippedFeatures2, faceNormal, referencePoint1, radius, true);
+		}
+	} else {
+		Vector2 sideNormal = capsule->globalEdgeNormals[capsuleSide];
+		float alignment;
+		int incidentEdge = findMostAlignedEdge(polygon, faceNormal, &alignment);
+		int incidentNext = (incidentEdge + 1) % numPoints;
+		Vector2 incidentPoints[2] = {points[incidentEdge], points[incidentNext]};
+		contactFeature incidentFeatures[2] = {makeContactFeature(0, incidentEdge, capsuleSide), makeContactFeature(0, incidentNext, capsuleSide)};
+		Vector2 tangent = vec2Sub(capsulePoints[1], capsulePoints[0]);
+		if (clipSegmentToLine(clipped1, clippedFeatures1, incidentPoints, incidentFeatures, vec2Negate(tangent), -vec2Dot(tangent, capsulePoints[0])) == 2 &&
+				clipSegmentToLine(clipped2, clippedFeatures2, clipped1, clippedFeatures1, tangent, vec2Dot(tangent, capsulePoints[1])) == 2) {
+			addClippedRoundContacts(&result, clipped2, clippedFeatures2, sideNormal, capsulePoints[0], radius, false);
+		}
+	}
+
+	if (coresApart) {
+		// the true depth comes from how close the cores are. if none of the clipped points gets
+		// that deep, the closest points are off the end of the face and it's a corner after all
+		float coreDepth = radius - coreDistance;
+		if (result.numContacts == 0 || result.penetrationDepth < coreDepth - ROUND_CORE_SLOP) {
+			return makeRoundContact(closestPolygon, 0.0f, closestCapsule, radius, faceNormal);
+		}
+		result.depth1 = fminf(result.depth1, coreDepth);
+		result.depth2 = fminf(result.depth2, coreDepth);
+		result.penetrationDepth = coreDepth;
+	}
+	if (result.numContacts == 0) {
+		// the cores overlap but nothing survived the clipping, fall back to whatever is furthest
+		// through the reference face
+		if (polygonReference) {
+			Vector2 referencePoint = points[polygonEdge];
+			float distance0 = vec2Dot(faceNormal, vec2Sub(capsulePoints[0], referencePoint));
+			float distance1 = vec2Dot(faceNormal, vec2Sub(capsulePoints[1], referencePoint));
+			int deepest = distance0 < distance1 ? 0 : 1;
+			float distance = fminf(distance0, distance1);
+			result.contact1 = vec2Sub(capsulePoints[deepest], vec2Scale(faceNormal, distance));
+			result.feature1 = makeContactFeature(1, deepest, polygonEdge);
+			result.penetrationDepth = radius - distance;
+		} else {
+			Vector2 sideNormal = capsule->globalEdgeNormals[capsuleSide];
+			int deepest = 0;
+			for (int i = 1; i < numPoints; i++) {
+				if (vec2Dot(sideNormal, points[i]) < vec2Dot(sideNormal, points[deepest])) {
+					deepest = i;
+				}
+			}
+			result.contact1 = points[deepest];
+			result.feature1 = makeContactFeature(0, deepest, capsuleSide);
+			result.penetrationDepth = radius - capsuleSeparation;
+		}
+		result.depth1 = result.penetrationDepth;
+		result.numContacts = 1;
+	}
+	result.isCollided = true;
+	// the caller pushes body1 along the normal
+	result.normal = vec2Negate(faceNormal);
+	return result;
+}
+
+// edges of a box in the order getRectPrototype lays out its corners, each named after where
+// its outward normal points in local space (y is down)
+#define BOX_EDGE_LEFT 0
+#define BOX_EDGE_BOTTOM 1
+#define BOX_EDGE_RIGHT 2
+#define BOX_EDGE_TOP 3
+
+// the box edge whose outward normal is closest to `direction`, given the box's local x and y axes
+int getBoxEdge(Vector2 direction, Vector2 axisX, Vector2 axisY) {
+	float alongX = vec2Dot(direction, axisX);
+	float alongY = vec2Dot(direction, axisY);
+	if (fabsf(alongX) > fabsf(alongY)) {
+		return alongX > 0.0f ? BOX_EDGE_RIGHT : BOX_EDGE_LEFT;
+	}
+	return alongY > 0.0f ? BOX_EDGE_BOTTOM : BOX_EDGE_TOP;
+}
+
+// oriented box against oriented box. there are only two axes per box, and how far a box reaches
+// along any axis comes straight from its half extents, so SAT is four subtractions. contacts
+// come from clipping the incident edge to the reference face, like polygons
+collisionResult collideBoxes(polygonCollisionShape *box1, polygonCollisionShape *box2, separatingAxis *cachedAxis) {
+	Vector2 half1 = box1->prototype->halfExtents;
+	Vector2 half2 = box2->prototype->halfExtents;
+	Vector2 center1 = vec2Scale(vec2Add(box1->globalPointArray[0], box1->globalPointArray[2]), 0.5f);
+	Vector2 center2 = vec2Scale(vec2Add(box2->globalPointArray[0], box2->globalPointArray[2]), 0.5f);
+	Vector2 axisX1 = box1->globalEdgeNormals[BOX_EDGE_RIGHT];
+	Vector2 axisY1 = box1->globalEdgeNormals[BOX_EDGE_BOTTOM];
+	Vector2 axisX2 = box2->globalEdgeNormals[BOX_EDGE_RIGHT];
+	Vector2 axisY2 = box2->globalEdgeNormals[BOX_EDGE_BOTTOM];
+	Vector2 offset = vec2Sub(center2, center1);
+
+	// how much of each axis of one box lies along each axis of the other
+	float xx = fabsf(vec2Dot(axisX1, axisX2));
+	float xy = fabsf(vec2Dot(axisX1, axisY2));
+	float yx = fabsf(vec2Dot(axisY1, axisX2));
+	float yy = fabsf(vec2Dot(axisY1, axisY2));
+
+	float separationX1 = fabsf(vec2Dot(axisX1, offset)) - half1.x - (xx * half2.x + xy * half2.y);
+	float separationY1 = fabsf(vec2Dot(axisY1, offset)) - half1.y - (yx * half2.x + yy * half2.y);
+	float separationX2 = fabsf(vec2Dot(axisX2, offset)) - half2.x - (xx * half1.x + yx * half1.y);
+	float separationY2 = fabsf(vec2Dot(axisY2, offset)) - half2.y - (xy * half1.x + yy * half1.y);
+	// touching doesn't count, same as SAT
+	if (separationX1 >= 0.0f || separationY1 >= 0.0f || separationX2 >= 0.0f || separationY2 >= 0.0f) {
+		return emptyCollisionResult();
+	}
+
+	// the axis that's penetrated the least, pointing from box1 to box2
+	float separation = fmaxf(fmaxf(separationX1, separationY1), fmaxf(separationX2, separationY2));
+	Vector2 axis = separation == separationX1 ? axisX1 : separation == separationY1 ? axisY1 : separation == separationX2 ? axisX2 : axisY2;
+	Vector2 normal = vec2Dot(axis, offset) < 0.0f ? vec2Negate(axis) : axis;
+
+	// the reference face is picked the same way as for polygons, so a long floor under a slightly
+	// tilted crate doesn't keep trading places with it
+	float alignment1 = fmaxf(fabsf(vec2Dot(normal, axisX1)), fabsf(vec2Dot(normal, axisY1)));
+	float alignment2 = fmaxf(fabsf(vec2Dot(normal, axisX2)), fabsf(vec2Dot(normal, axisY2)));
+	bool flip = alignment2 > alignment1 + REFERENCE_FACE_TOLERANCE;
+
+	polygonCollisionShape *incident = flip ? box1 : box2;
+	Vector2 referenceCenter = flip ? center2 : center1;
+	Vector2 referenceHalf = flip ? half2 : half1;
+	Vector2 referenceX = flip ? axisX2 : axisX1;
+	Vector2 referenceY = flip ? axisY2 : axisY1;
+	// the reference box's own face normal, pointing towards the incident box
+	Vector2 towardsIncident = flip ? vec2Negate(normal) : normal;
+	bool alongX = fabsf(vec2Dot(towardsIncident, referenceX)) > fabsf(vec2Dot(towardsIncident, referenceY));
+	Vector2 faceNormal = alongX ? referenceX : referenceY;
+	if (vec2Dot(faceNormal, towardsIncident) < 0.0f) {
+		faceNormal = vec2Negate(faceNormal);
+	}
+	Vector2 tangent = alongX ? referenceY : referenceX;
+	float faceExtent = alongX ? referenceHalf.x : referenceHalf.y;
+	float sideExtent = alongX ? referenceHalf.y : referenceHalf.x;
+	int referenceEdge = getBoxEdge(faceNormal, referenceX, referenceY);
+
+	// the incident edge faces back against the reference face
+	Vector2 incidentX = flip ? axisX1 : axisX2;
+	Vector2 incidentY = flip ? axisY1 : axisY2;
+	int incidentEdge = getBoxEdge(vec2Negate(faceNormal), incidentX, incidentY);
+	int incidentNext = (incidentEdge + 1) & 3;
+	int incidentShape = flip ? 0 : 1;
+	Vector2 incidentPoints[2] = {incident->globalPointArray[incidentEdge], incident->globalPointArray[incidentNext]};
+	contactFeature incidentFeatures[2] = {
+		makeContactFeature(incidentShape, incidentEdge, referenceEdge),
+		makeContactFeature(incidentShape, incidentNext, referenceEdge)
+	};
+
+	collisionResult result = emptyCollisionResult();
+	float tangentCenter = vec2Dot(tangent, referenceCenter);
+	Vector2 clipped1[2], clipped2[2];
+	contactFeature clippedFeatures1[2], clippedFeatures2[2];
+	int clippedCount = 0;
+	if (clipSegmentToLine(clipped1, clippedFeatures1, incidentPoints, incidentFeatures, vec2Negate(tangent), sideExtent - tangentCenter) == 2) {
+		clippedCount = clipSegmentToLine(clipped2, clippedFeatures2, clipped1, clippedFeatures1, tangent, tangentCenter + sideExtent);
+	}
+	addFaceContacts(&result, clipped2, clippedFeatures2, clippedCount == 2 ? 2 : 0,
+			incidentPoints, incidentFeatures, faceNormal, vec2Dot(faceNormal, referenceCenter) + faceExtent);
+	result.isCollided = true;
+	result.penetrationDepth = -separation;
+	// the caller pushes body1 along the normal, so it has to point back towards it
+	result.normal = vec2Negate(normal);
+	return result;
+}
+
+typedef collisionResult (*shapeCollider)(polygonCollisionShape *shape1, polygonCollisionShape *shape2, separatingAxis *cachedAxis);
+
+// one collider per pair of shape types. only one order of each pair is filled in,
+// collideShapes swaps the shapes around for the other
+shapeCollider shapeColliders[SHAPE_TYPE_COUNT][SHAPE_TYPE_COUNT] = {
+	[SHAPE_POLYGON][SHAPE_POLYGON] = collidePolygons,
+	// boxes are polygons to everything but other boxes
+	[SHAPE_POLYGON][SHAPE_BOX] = collidePolygons,
+	[SHAPE_BOX][SHAPE_POLYGON] = collidePolygons,
+	[SHAPE_BOX][SHAPE_BOX] = collideBoxes,
+	[SHAPE_BOX][SHAPE_CIRCLE] = collidePolygonCircle,
+	[SHAPE_BOX][SHAPE_CAPSULE] = collidePolygonCapsule,
+	[SHAPE_POLYGON][SHAPE_CIRCLE] = collidePolygonCircle,
+	[SHAPE_POLYGON][SHAPE_CAPSULE] = collidePolygonCapsule,
+	[SHAPE_CIRCLE][SHAPE_CIRCLE] = collideCircles,
+	[SHAPE_CIRCLE][SHAPE_CAPSULE] = collideCircleCapsule,
+	[SHAPE_CAPSULE][SHAPE_CAPSULE] = collideCapsules,
+};
+
+// only the general polygon SAT starts from the cached axis and hands back a new one. the others,
+// and polygon pairs big enough for collidePolygons to hand to GJK, work everything out from
+// scratch, so a pair of them shouldn't bother with the cache at all
+bool shapesUseSeparatingAxis(polygonCollisionShape *shape1, polygonCollisionShape *shape2) {
+	shapeCollider collider = shapeColliders[shape1->type][shape2->type] != NULL ? shapeColliders[shape1->type][shape2->type] : shapeColliders[shape2->type][shape1->type];
+	return collider == collidePolygons && shape1->numPoints + shape2->numPoints <= GJK_POINT_THRESHOLD;
+}
+
+// the narrowphase for any two shapes. the result's normal points towards shape1
+collisionResult collideShapes(polygonCollisionShape *shape1, polygonCollisionShape *shape2, separatingAxis *cachedAxis) {
+	shapeCollider collider = shapeColliders[shape1->type][shape2->type];
+	if (collider != NULL) {
+		return collider(shape1, shape2, cachedAxis);
+	}
+	// the cached axis only means anything for polygon pairs, which never get swapped
+	collisionResult result = shapeColliders[shape2->type][shape1->type](shape2, shape1, NULL);
+	result.normal = vec2Negate(result.normal);
+	return result;
+}
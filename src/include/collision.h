@@ -1,22 +1,8 @@
-float getOverlap(Vector2 axis, int numPoints1, Vector2* points1, int numPoints2, Vector2* points2) {
-  float min1 = INFINITY;
-  float max1 = -INFINITY;
-  // Find the extreme points on each axis for the first polygon
-  for (int i = 0; i < numPoints1; i++) {
-    float dotProduct = vec2Dot(points1[i], axis);
-    if (dotProduct < min1) min1 = dotProduct;
-    if (dotProduct > max1) max1 = dotProduct;
-  }
-
-  float min2 = INFINITY;
-  float max2 = -INFINITY;
-  // Do the same thing again for the second polygon
-  for (int i = 0; i < numPoints2; i++) {
-
-    float dotProduct = vec2Dot(points2[i], axis);
-    if (dotProduct < min2) min2 = dotProduct;
-    if (dotProduct > max2) max2 = dotProduct;
-  }
+float getOverlap(Vector2 axis, polygonCollisionShape *shape1, polygonCollisionShape *shape2) {
+  // Find the extreme points of each polygon on the axis
+  float min1, max1, min2, max2;
+  projectShapeOntoAxis(shape1, axis, &min1, &max1);
+  projectShapeOntoAxis(shape2, axis, &min2, &max2);
 
   // Check for collision using the extreme points
   float overlap1 = max1 - min2;
@@ -31,140 +17,210 @@ float getOverlap(Vector2 axis, int numPoints1, Vector2* points1, int numPoints2,
   }
 }
 
-void pointSegmentDistance(Vector2 p, Vector2 point1, Vector2 point2, float *distSq, Vector2 *cp) {
-    float l2 = vec2DistSquared(point1, point2);
-    if (l2 == 0.0f) {
-        *distSq = vec2DistSquared(p, point1);
-        *cp = point1;
-    } else {
-        float t = fmaxf(0.0f, fminf(1.0f, ((p.x - point1.x) * (point2.x - point1.x) + (p.y - point1.y) * (point2.y - point1.y)) / l2));
-        Vector2 projection = {point1.x + t * (point2.x - point1.x), point1.y + t * (point2.y - point1.y)};
-        *distSq = vec2DistSquared(p, projection);
-        *cp = projection;
+// a face on the second shape has to line up this much better with the collision normal to be
+// picked as the reference face, so the choice doesn't flicker between two nearly parallel faces
+#define REFERENCE_FACE_TOLERANCE 0.001f
+
+// the edge whose outward normal points furthest along `direction`
+int findMostAlignedEdge(polygonCollisionShape *shape, Vector2 direction, float *alignment) {
+  int bestEdge = 0;
+  float bestDot = -INFINITY;
+  for (int i = 0; i < shape->numPoints; i++) {
+    float dotProduct = vec2Dot(shape->globalEdgeNormals[i], direction);
+    if (dotProduct > bestDot) {
+      bestDot = dotProduct;
+      bestEdge = i;
     }
+  }
+  *alignment = bestDot;
+  return bestEdge;
 }
 
-void findPolygonContactPoints(
-    Vector2 *points1, int numPoints1,
-    Vector2 *points2, int numPoints2,
-    Vector2 *contact1, Vector2 *contact2, int *contactCount) {
-
-    *contact1 = (Vector2){0,0};
-    *contact2 = (Vector2){0,0};
-    *contactCount = 0;
-
-    float minDistSq = INFINITY;
-
-    for (int i = 0; i < numPoints1; i++) {
-        Vector2 p = points1[i];
-
-        for (int j = 0; j < numPoints2; j++) {
-            Vector2 point1 = points2[j];
-            Vector2 point2 = points2[(j + 1) % numPoints2];
-
-            float distSq;
-            Vector2 cp;
-            pointSegmentDistance(p, point1, point2, &distSq, &cp);
-
-            if (fabsf(distSq - minDistSq) < FLT_EPSILON) {
-                if (!(cp.x == contact1->x && cp.y == contact1->y)) {
-                    *contact2 = cp;
-                    *contactCount = 2;
-                }
-            } else if (distSq < minDistSq) {
-                minDistSq = distSq;
-                *contactCount = 1;
-                *contact1 = cp;
-            }
-        }
-    }
+// keeps the part of the segment where dot(normal, point) <= offset.
+// a point that gets clipped keeps the feature of the endpoint it replaced
+int clipSegmentToLine(Vector2 *outPoints, contactFeature *outFeatures, Vector2 *inPoints, contactFeature *inFeatures, Vector2 normal, float offset) {
+  int count = 0;
+  float distance1 = vec2Dot(normal, inPoints[0]) - offset;
+  float distance2 = vec2Dot(normal, inPoints[1]) - offset;
 
-    for (int i = 0; i < numPoints2; i++) {
-        Vector2 p = points2[i];
-
-        for (int j = 0; j < numPoints1; j++) {
-            Vector2 point1 = points1[j];
-            Vector2 point2 = points1[(j + 1) % numPoints1];
-
-            float distSq;
-            Vector2 cp;
-            pointSegmentDistance(p, point1, point2, &distSq, &cp);
-
-            if (fabsf(distSq - minDistSq) < FLT_EPSILON) {
-                if (!(cp.x == contact1->x && cp.y == contact1->y)) {
-                    *contact2 = cp;
-                    *contactCount = 2;
-                }
-            } else if (distSq < minDistSq) {
-                minDistSq = distSq;
-                *contactCount = 1;
-                *contact1 = cp;
-            }
-        }
+  if (distance1 <= 0.0f) {
+    outPoints[count] = inPoints[0];
+    outFeatures[count++] = inFeatures[0];
+  }
+  if (distance2 <= 0.0f) {
+    outPoints[count] = inPoints[1];
+    outFeatures[count++] = inFeatures[1];
+  }
+  // the endpoints are on opposite sides, add the point where the segment crosses
+  if (distance1 * distance2 < 0.0f) {
+    float t = distance1 / (distance1 - distance2);
+    outPoints[count] = vec2Add(inPoints[0], vec2Scale(vec2Sub(inPoints[1], inPoints[0]), t));
+    outFeatures[count++] = distance1 > 0.0f ? inFeatures[0] : inFeatures[1];
+  }
+  return count;
+}
+
+// keeps the clipped points that are below the reference face and moves them onto it.
+// `clippedCount` is how many points survived clipping the incident edge to the face's sides.
+// if none of them are below the face, the deepest incident vertex becomes the one contact, so a
+// collision always has something to push on
+void addFaceContacts(collisionResult *result, Vector2 *clipped, contactFeature *clippedFeatures, int clippedCount,
+    Vector2 *incidentPoints, contactFeature *incidentFeatures, Vector2 faceNormal, float faceOffset) {
+  Vector2 *contacts[2] = {&result->contact1, &result->contact2};
+  contactFeature *features[2] = {&result->feature1, &result->feature2};
+  float *depths[2] = {&result->depth1, &result->depth2};
+  result->numContacts = 0;
+  for (int i = 0; i < clippedCount; i++) {
+    float separation = vec2Dot(faceNormal, clipped[i]) - faceOffset;
+    if (separation <= 0.0f) {
+      *contacts[result->numContacts] = vec2Sub(clipped[i], vec2Scale(faceNormal, separation));
+      *features[result->numContacts] = clippedFeatures[i];
+      *depths[result->numContacts] = -separation;
+      result->numContacts++;
     }
+  }
+  if (result->numContacts > 0) {
+    return;
+  }
+  float separation1 = vec2Dot(faceNormal, incidentPoints[0]) - faceOffset;
+  float separation2 = vec2Dot(faceNormal, incidentPoints[1]) - faceOffset;
+  int deepest = separation1 <= separation2 ? 0 : 1;
+  float separation = fminf(separation1, separation2);
+  result->contact1 = vec2Sub(incidentPoints[deepest], vec2Scale(faceNormal, separation));
+  result->feature1 = incidentFeatures[deepest];
+  result->depth1 = fmaxf(-separation, 0.0f);
+  result->numContacts = 1;
 }
 
-collisionResult polygonIntersect(physicsObject *object1, physicsObject *object2) {
+// builds up to two contact points by clipping the incident edge (the edge of one shape facing
+// most against the collision normal) to the sides of the reference edge (the face of the other
+// shape best lined up with it). `normal` points from shape1 towards shape2.
+// each point is tagged with the incident vertex it came from and the reference edge, which stay
+// the same from step to step while the shapes rest on each other
+void findPolygonContactPoints(polygonCollisionShape *shape1, polygonCollisionShape *shape2, Vector2 normal, collisionResult *result) {
+  float alignment1, alignment2;
+  int edge1 = findMostAlignedEdge(shape1, normal, &alignment1);
+  int edge2 = findMostAlignedEdge(shape2, vec2Negate(normal), &alignment2);
+
+  bool flip = alignment2 > alignment1 + REFERENCE_FACE_TOLERANCE;
+  polygonCollisionShape *reference = flip ? shape2 : shape1;
+  polygonCollisionShape *incident = flip ? shape1 : shape2;
+  int referenceEdge = flip ? edge2 : edge1;
+  Vector2 referenceNormal = reference->globalEdgeNormals[referenceEdge];
+
+  // the incident edge faces most against the reference face
+  float incidentAlignment;
+  int incidentEdge = findMostAlignedEdge(incident, vec2Negate(referenceNormal), &incidentAlignment);
+  int incidentNext = (incidentEdge + 1) % incident->numPoints;
+  int incidentShape = flip ? 0 : 1;
+  Vector2 incidentPoints[2] = {incident->globalPointArray[incidentEdge], incident->globalPointArray[incidentNext]};
+  contactFeature incidentFeatures[2] = {
+    makeContactFeature(incidentShape, incidentEdge, referenceEdge),
+    makeContactFeature(incidentShape, incidentNext, referenceEdge)
+  };
+
+  // the sides of the reference face, the direction doesn't need to be unit length
+  Vector2 referencePoint1 = reference->globalPointArray[referenceEdge];
+  Vector2 referencePoint2 = reference->globalPointArray[(referenceEdge + 1) % reference->numPoints];
+  Vector2 tangent = vec2Sub(referencePoint2, referencePoint1);
+
+  Vector2 clipped1[2], clipped2[2];
+  contactFeature clippedFeatures1[2], clippedFeatures2[2];
+  int clippedCount = 0;
+  if (clipSegmentToLine(clipped1, clippedFeatures1, incidentPoints, incidentFeatures, vec2Negate(tangent), -vec2Dot(tangent, referencePoint1)) == 2) {
+    clippedCount = clipSegmentToLine(clipped2, clippedFeatures2, clipped1, clippedFeatures1, tangent, vec2Dot(tangent, referencePoint2));
+  }
+  addFaceContacts(result, clipped2, clippedFeatures2, clippedCount == 2 ? 2 : 0,
+      incidentPoints, incidentFeatures, referenceNormal, vec2Dot(referenceNormal, referencePoint1));
+}
 
-  int numPoints1 = object1->collisionShape->numPoints;
-  int numPoints2 = object2->collisionShape->numPoints;
-  Vector2 *points1 = object1->collisionShape->globalPointArray;
-  Vector2 *points2 = object2->collisionShape->globalPointArray;
+// axes are numbered through shape1's edges and then shape2's
+void rememberSeparatingAxis(separatingAxis *cachedAxis, int axisIndex, int numPoints1) {
+  if (cachedAxis == NULL) {
+    return;
+  }
+  cachedAxis->shape = axisIndex < numPoints1 ? 0 : 1;
+  cachedAxis->edge = axisIndex < numPoints1 ? axisIndex : axisIndex - numPoints1;
+}
+
+// `cachedAxis` can be NULL. otherwise it's tried before anything else, and afterwards holds the
+// axis that seperated the shapes, or the one with the least overlap if they collided
+collisionResult polygonIntersect(polygonCollisionShape *shape1, polygonCollisionShape *shape2, separatingAxis *cachedAxis) {
+
+  int numPoints1 = shape1->numPoints;
+  int numPoints2 = shape2->numPoints;
 
   collisionResult result;
   result.normal = (Vector2){0,0};
-  result.object1 = object1;
-  result.object2 = object2;
+  result.body1 = -1;
+  result.body2 = -1;
   result.isCollided = false;
   result.numContacts = 0;
   result.contact1 = (Vector2){0,0};
   result.contact2 = (Vector2){0,0};
+  result.feature1 = 0;
+  result.feature2 = 0;
+  result.depth1 = 0.0f;
+  result.depth2 = 0.0f;
   result.penetrationDepth = 0.0f;
+  result.pairKey = 0;
+
+  // whatever seperated the pair last time very likely still does
+  if (cachedAxis != NULL && cachedAxis->shape >= 0) {
+    polygonCollisionShape *owner = cachedAxis->shape == 0 ? shape1 : shape2;
+    // the slot may have been reused by a different shape since
+    if (cachedAxis->edge < owner->numPoints) {
+      Vector2 axis = owner->globalEdgeNormals[cachedAxis->edge];
+      if (getOverlap(axis, shape1, shape2) == 0.0f) {
+        return result;
+      }
+    }
+  }
 
+  // every edge normal of both shapes is a candidate seperating axis. the normals are already
+  // unit length and in world space, so nothing needs normalizing here. they get projected
+  // SAT_AXIS_BATCH at a time, and any batch holding a seperating axis ends the test early
+  int numAxes = numPoints1 + numPoints2;
   float minOverlap = INFINITY;
-  // iterate over every single edge on the first shape and check for a seperating axis
-  for (int i = 0; i < numPoints1;  i++) {
-    int nextIndex = (i + 1) % numPoints1;
-    Vector2 edge = (Vector2){points1[i].x - points1[nextIndex].x, points1[i].y - points1[nextIndex].y};
-    Vector2 axis = vec2Normalize(vec2Perp(edge));
-    float overlap = getOverlap(axis, numPoints1, points1, numPoints2, points2);
-    if (overlap == 0.0f) {
-      return result;
-    } else if (overlap < minOverlap){
-        result.normal = axis;
-        result.penetrationDepth = overlap;
-        minOverlap = overlap;
+  int bestAxis = 0;
+  for (int first = 0; first < numAxes; first += SAT_AXIS_BATCH) {
+    float axisX[SAT_AXIS_BATCH];
+    float axisY[SAT_AXIS_BATCH];
+    for (int a = 0; a < SAT_AXIS_BATCH; a++) {
+      // a short last batch repeats its final axis
+      int axisIndex = first + a < numAxes ? first + a : numAxes - 1;
+      Vector2 axis = axisIndex < numPoints1 ? shape1->globalEdgeNormals[axisIndex] : shape2->globalEdgeNormals[axisIndex - numPoints1];
+      axisX[a] = axis.x;
+      axisY[a] = axis.y;
     }
-  }
-  // iterate over the second shape
-  for (int i = 0; i < numPoints2;  i++) {
-    int nextIndex = (i + 1) % numPoints2;
-    Vector2 edge = (Vector2){points2[i].x - points2[nextIndex].x, points2[i].y - points2[nextIndex].y};
-    Vector2 axis = vec2Normalize(vec2Perp(edge));
-    float overlap = getOverlap(axis, numPoints1, points1, numPoints2, points2);
-    if (overlap == 0.0f) {
-      return result;
-    } else if (overlap < minOverlap){
-        result.normal = axis;
+
+    float min1[SAT_AXIS_BATCH], max1[SAT_AXIS_BATCH];
+    float min2[SAT_AXIS_BATCH], max2[SAT_AXIS_BATCH];
+    projectPointsOntoAxes(shape1->globalX, shape1->globalY, shape1->paddedNumPoints, axisX, axisY, min1, max1);
+    projectPointsOntoAxes(shape2->globalX, shape2->globalY, shape2->paddedNumPoints, axisX, axisY, min2, max2);
+
+    for (int a = 0; a < SAT_AXIS_BATCH; a++) {
+      float overlap1 = max1[a] - min2[a];
+      float overlap2 = max2[a] - min1[a];
+      float overlap = overlap1 < 0 || overlap2 < 0 ? 0.0f : fminf(overlap1, overlap2);
+      if (overlap == 0.0f) {
+        rememberSeparatingAxis(cachedAxis, first + a, numPoints1);
+        return result;
+      } else if (overlap < minOverlap) {
+        // the shapes get pushed apart whichever way along the axis is shorter, the normal
+        // is kept pointing from shape1 towards shape2 until the end
+        result.normal = overlap2 < overlap1 ? (Vector2){-axisX[a], -axisY[a]} : (Vector2){axisX[a], axisY[a]};
         result.penetrationDepth = overlap;
         minOverlap = overlap;
+        bestAxis = first + a < numAxes ? first + a : numAxes - 1;
+      }
     }
-
   }
+  rememberSeparatingAxis(cachedAxis, bestAxis, numPoints1);
   result.isCollided = true;
-  findPolygonContactPoints(
-		object1->collisionShape->globalPointArray,
-		object1->collisionShape->numPoints,
-		object2->collisionShape->globalPointArray,
-		object2->collisionShape->numPoints,
-		&result.contact1,
-		&result.contact2,
-		&result.numContacts
-	);
-  if (vec2Dot(object1->position, result.normal) < vec2Dot(object2->position, result.normal)) {
-		result.normal = vec2Negate(result.normal);
-	}
-  // if there are no seperating axes, the shapes have indeed collided
+  findPolygonContactPoints(shape1, shape2, result.normal, &result);
+  // the caller pushes body1 along the normal, so it has to point back towards it
+  result.normal = vec2Negate(result.normal);
   return result;
 }
 
@@ -0,0 +1,153 @@
+// pairs with more points than this between them go through GJK and EPA instead of SAT.
+// SAT projects every point onto every axis, which gets slow for big convex hulls
+#define GJK_POINT_THRESHOLD 24
+#define GJK_MAX_ITERATIONS 64
+// EPA stops once the polytope can't grow by more than this along the closest edge
+#define EPA_TOLERANCE 0.001f
+#define EPA_MAX_POINTS 160
+
+// the point of the minkowski difference shape1 - shape2 furthest along `direction`
+Vector2 getMinkowskiSupport(polygonCollisionShape *shape1, polygonCollisionShape *shape2, Vector2 direction) {
+	return vec2Sub(getSupportPoint(shape1, direction), getSupportPoint(shape2, vec2Negate(direction)));
+}
+
+// the perpendicular of `edge` on the same side as `towards`
+Vector2 getPerpTowards(Vector2 edge, Vector2 towards) {
+	Vector2 perp = (Vector2){-edge.y, edge.x};
+	return vec2Dot(perp, towards) < 0.0f ? vec2Negate(perp) : perp;
+}
+
+// true if the shapes overlap, in which case `simplex` ends up as a triangle around the origin.
+// shapes that only touch don't count, same as with SAT
+bool gjkIntersect(polygonCollisionShape *shape1, polygonCollisionShape *shape2, Vector2 *simplex) {
+	Vector2 direction = vec2Sub(shape2->globalPointArray[0], shape1->globalPointArray[0]);
+	if (direction.x == 0.0f && direction.y == 0.0f) {
+		direction = (Vector2){1.0f, 0.0f};
+	}
+	simplex[0] = getMinkowskiSupport(shape1, shape2, direction);
+	int count = 1;
+	direction = vec2Negate(simplex[0]);
+
+	for (int iteration = 0; iteration < GJK_MAX_ITERATIONS; iteration++) {
+		if (direction.x == 0.0f && direction.y == 0.0f) {
+			return false;
+		}
+		Vector2 point = getMinkowskiSupport(shape1, shape2, direction);
+		// couldn't get past the origin, so it's outside the difference
+		if (vec2Dot(point, direction) <= 0.0f) {
+			return false;
+		}
+		simplex[count++] = point;
+
+		// the newest point is always last
+		Vector2 a = simplex[count - 1];
+		Vector2 toOrigin = vec2Negate(a);
+		if (count == 2) {
+			Vector2 ab = vec2Sub(simplex[0], a);
+			if (vec2Dot(ab, toOrigin) > 0.0f) {
+				// the origin lies on the line, the shapes are just touching
+				if (vec2Cross(ab, toOrigin) == 0.0f) {
+					return false;
+				}
+				direction = getPerpTowards(ab, toOrigin);
+			} else {
+				simplex[0] = a;
+				count = 1;
+				direction = toOrigin;
+			}
+		} else {
+			Vector2 b = simplex[1];
+			Vector2 c = simplex[0];
+			Vector2 ab = vec2Sub(b, a);
+			Vector2 ac = vec2Sub(c, a);
+			Vector2 abPerp = getPerpTowards(ab, vec2Negate(ac));
+			Vector2 acPerp = getPerpTowards(ac, vec2Negate(ab));
+			if (vec2Dot(abPerp, toOrigin) > 0.0f) {
+				simplex[0] = b;
+				simplex[1] = a;
+				count = 2;
+				direction = abPerp;
+			} else if (vec2Dot(acPerp, toOrigin) > 0.0f) {
+				simplex[1] = a;
+				count = 2;
+				direction = acPerp;
+			} else {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// expands the GJK triangle towards the edge of the minkowski difference closest to the origin.
+// that edge's normal (pointing from shape1 towards shape2) and distance are how far the shapes
+// have to move apart
+void epaPenetration(polygonCollisionShape *shape1, polygonCollisionShape *shape2, Vector2 *simplex, Vector2 *normal, float *depth) {
+	Vector2 polytope[EPA_MAX_POINTS];
+	int count = 3;
+	polytope[0] = simplex[0];
+	polytope[1] = simplex[1];
+	polytope[2] = simplex[2];
+	// counter clockwise keeps the right hand perpendicular of every edge pointing out
+	if (vec2Cross(vec2Sub(polytope[1], polytope[0]), vec2Sub(polytope[2], polytope[0])) < 0.0f) {
+		polytope[1] = simplex[2];
+		polytope[2] = simplex[1];
+	}
+
+	for (;;) {
+		int closestEdge = 0;
+		float closestDistance = INFINITY;
+		Vector2 closestNormal = (Vector2){0, 0};
+		for (int i = 0; i < count; i++) {
+			Vector2 edge = vec2Sub(polytope[(i + 1) % count], polytope[i]);
+			Vector2 edgeNormal = vec2Normalize((Vector2){edge.y, -edge.x});
+			float distance = vec2Dot(edgeNormal, polytope[i]);
+			if (distance < closestDistance) {
+				closestDistance = distance;
+				closestNormal = edgeNormal;
+				closestEdge = i;
+			}
+		}
+
+		Vector2 point = getMinkowskiSupport(shape1, shape2, closestNormal);
+		if (vec2Dot(point, closestNormal) - closestDistance < EPA_TOLERANCE || count == EPA_MAX_POINTS) {
+			*normal = closestNormal;
+			*depth = closestDistance;
+			return;
+		}
+		for (int i = count; i > closestEdge + 1; i--) {
+			polytope[i] = polytope[i - 1];
+		}
+		polytope[closestEdge + 1] = point;
+		count++;
+	}
+}
+
+// same result as polygonIntersect, for shapes too big for SAT
+collisionResult gjkPolygonIntersect(polygonCollisionShape *shape1, polygonCollisionShape *shape2) {
+	collisionResult result = {0};
+	result.body1 = -1;
+	result.body2 = -1;
+
+	Vector2 simplex[3];
+	if (!gjkIntersect(shape1, shape2, simplex)) {
+		return result;
+	}
+	epaPenetration(shape1, shape2, simplex, &result.normal, &result.penetrationDepth);
+	if (result.penetrationDepth <= 0.0f) {
+		return result;
+	}
+	result.isCollided = true;
+	findPolygonContactPoints(shape1, shape2, result.normal, &result);
+	// the caller pushes body1 along the normal, so it has to point back towards it
+	result.normal = vec2Negate(result.normal);
+	return result;
+}
+
+// picks SAT or GJK depending on how many points the two shapes have
+collisionResult collidePolygons(polygonCollisionShape *shape1, polygonCollisionShape *shape2, separatingAxis *cachedAxis) {
+	if (shape1->numPoints + shape2->numPoints > GJK_POINT_THRESHOLD) {
+		return gjkPolygonIntersect(shape1, shape2);
+	}
+	return polygonIntersect(shape1, shape2, cachedAxis);
+}
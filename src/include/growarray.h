@@ -0,0 +1,38 @@
+// grow a heap array so it can hold at least `needed` elements.
+// capacity doubles so repeated pushes are amortised O(1)
+void *growArray(void *array, int *capacity, int needed, size_t elementSize) {
+	if (needed <= *capacity) {
+		return array;
+	}
+	int newCapacity = *capacity > 0 ? *capacity : 16;
+	while (newCapacity < needed) {
+		newCapacity *= 2;
+	}
+	void *newArray = realloc(array, (size_t)newCapacity * elementSize);
+	if (newArray == NULL) {
+		fprintf(stderr, "shart2D: out of memory growing array to %d elements\n", newCapacity);
+		exit(1);
+	}
+	*capacity = newCapacity;
+	return newArray;
+}
+
+// alignment of the arrays the hot simulation loops stream through
+#define SIMD_ALIGNMENT 32
+
+// moves the first `count` elements into a new SIMD aligned block big enough for `capacity` elements
+void *reallocAligned(void *array, int count, int capacity, size_t elementSize) {
+	size_t size = (size_t)capacity * elementSize;
+	// aligned_alloc wants the size to be a multiple of the alignment
+	size = (size + SIMD_ALIGNMENT - 1) / SIMD_ALIGNMENT * SIMD_ALIGNMENT;
+	void *newArray = aligned_alloc(SIMD_ALIGNMENT, size);
+	if (newArray == NULL) {
+		fprintf(stderr, "shart2D: out of memory growing array to %d elements\n", capacity);
+		exit(1);
+	}
+	if (array != NULL) {
+		memcpy(newArray, array, (size_t)count * elementSize);
+		free(array);
+	}
+	return newArray;
+}
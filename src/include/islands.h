@@ -0,0 +1,324 @@
+// bodies slower than this (in units and radians per frame) count as resting
+#define SLEEP_LINEAR_VELOCITY 0.1f
+#define SLEEP_ANGULAR_VELOCITY 0.005f
+// so do bodies that haven't got further than this (in units and radians) from where they started
+// resting. the solver's jitter in a tall stack spikes past the velocities every now and then,
+// but it doesn't go anywhere
+#define SLEEP_LINEAR_TOLERANCE 0.5f
+#define SLEEP_ANGULAR_TOLERANCE 0.02f
+// how long, in frames, a whole island has to rest before it goes to sleep
+#define SLEEP_TIME 30.0f
+// islands with at least this many contacts are too much for one thread, the solver graph
+// colours those instead of solving them whole
+#define LARGE_ISLAND_CONTACTS 128
+
+// a sleeping island that was resting on a static body when it fell asleep
+typedef struct {
+	int staticSlot;
+	int bodySlot; // any body of the island
+	int islandId;
+} restingIsland;
+
+// groups awake bodies into islands, sets of bodies connected through contacts.
+// static bodies never join an island, otherwise everything on the floor would be one island.
+// the arrays are reused from step to step
+typedef struct {
+	int *parent;
+	int parentCapacity;
+	float *islandSleepTime; // the smallest sleepTime in each island, indexed by its root
+	int sleepTimeCapacity;
+	int nextIslandId; // every island that falls asleep gets a new one
+
+	// the islands that fell asleep touching a static body, so removing it can wake just those.
+	// islands that have woken up since are only cleared out once the array fills up
+	restingIsland *resting;
+	int restingCount;
+	int restingCapacity;
+
+	// the contacts of each island as the solver sees them, see groupContactsByIsland
+	int *rootIsland; // which island a root body ended up as, -1 if none yet
+	int rootIslandCapacity;
+	int *contactIsland;
+	int contactIslandCapacity;
+	int *islandStart; // island i owns contacts [islandStart[i], islandStart[i + 1])
+	int islandStartCapacity;
+	int *islandOrder; // where each island moves to so the large ones end up last
+	int islandOrderCapacity;
+	int islandCount;
+	int largeIslandStart; // the first island with LARGE_ISLAND_CONTACTS or more
+	collisionResult *groupedContacts;
+	int groupedCapacity;
+} islandBuilder;
+
+int findIslandRoot(int *parent, int index) {
+	while (parent[index] != index) {
+		// point every other body at its grandparent on the way up, keeps the trees flat
+		parent[index] = parent[parent[index]];
+		index = parent[index];
+	}
+	return index;
+}
+
+void joinIslands(int *parent, int index1, int index2) {
+	int root1 = findIslandRoot(parent, index1);
+	int root2 = findIslandRoot(parent, index2);
+	if (root1 != root2) {
+		// the lower index always wins so the result doesn't depend on contact order
+		if (root1 < root2) {
+			parent[root2] = root1;
+		} else {
+			parent[root1] = root2;
+		}
+	}
+}
+
+// wakes the body and everything that went to sleep in the same island as it
+void wakeBody(bodyPool *pool, int index) {
+	if (pool->awake[index] || pool->objects[index].isStaticBody) {
+		return;
+	}
+	// walk the island's ring, unlinking it on the way
+	int slot = pool->denseToSlot[index];
+	while (slot != NULL_BODY_SLOT) {
+		int i = pool->slots[slot].denseIndex;
+		setBodyAwake(pool, i, true);
+		pool->sleepTime[i] = 0.0f;
+		slot = pool->islandNext[i];
+		pool->islandNext[i] = NULL_BODY_SLOT;
+	}
+}
+
+// for when something moves without an awake body touching it first
+void wakeBodiesTouching(bodyPool *pool, AABB *box) {
+	for (int i = 0; i < pool->count; i++) {
+		if (!pool->awake[i] && AABBIntersect(&pool->box[i], box)) {
+			wakeBody(pool, i);
+		}
+	}
+}
+
+// where the body the record points at sits, or -1 if its island has woken up since
+int findRestingIsland(bodyPool *pool, restingIsland *resting) {
+	if (resting->bodySlot >= pool->slotCount) {
+		return -1;
+	}
+	int index = pool->slots[resting->bodySlot].denseIndex;
+	// free slots hold the next free slot instead, so check the body really is in it
+	if (index < 0 || index >= pool->count || pool->denseToSlot[index] != resting->bodySlot) {
+		return -1;
+	}
+	if (pool->awake[index] || pool->islandId[index] != resting->islandId) {
+		return -1;
+	}
+	return index;
+}
+
+void addRestingIsland(islandBuilder *islands, bodyPool *pool, int staticIndex, int bodyIndex) {
+	if (islands->restingCount == islands->restingCapacity) {
+		int kept = 0;
+		for (int i = 0; i < islands->restingCount; i++) {
+			if (findRestingIsland(pool, &islands->resting[i]) >= 0) {
+				islands->resting[kept++] = islands->resting[i];
+			}
+		}
+		islands->restingCount = kept;
+		// leave room for as many again, so clearing out doesn't happen on every add
+		islands->resting = growArray(islands->resting, &islands->restingCapacity, kept * 2 + 1, sizeof(restingIsland));
+	}
+	islands->resting[islands->restingCount++] = (restingIsland){
+		pool->denseToSlot[staticIndex], pool->denseToSlot[bodyIndex], pool->islandId[bodyIndex]
+	};
+}
+
+// wakes every island that went to sleep on the static body, for when it is about to vanish
+void wakeIslandsRestingOn(islandBuilder *islands, bodyPool *pool, int staticIndex) {
+	int staticSlot = pool->denseToSlot[staticIndex];
+	for (int i = 0; i < islands->restingCount; i++) {
+		if (islands->resting[i].staticSlot != staticSlot) {
+			continue;
+		}
+		int index = findRestingIsland(pool, &islands->resting[i]);
+		if (index >= 0) {
+			wakeBody(pool, index);
+		}
+		islands->resting[i--] = islands->resting[--islands->restingCount];
+	}
+}
+
+// advances every awake body's sleep timer by `deltaTime` frames, then puts every island whose
+// bodies have all been resting long enough to sleep. `contacts` should be this step's contacts,
+// which only ever involve awake bodies. only walks the active bodies, every awake one is on it
+void updateIslands(islandBuilder *islands, bodyPool *pool, contactList *contacts, float deltaTime) {
+	islands->parent = growArray(islands->parent, &islands->parentCapacity, pool->count, sizeof(int));
+	islands->islandSleepTime = growArray(islands->islandSleepTime, &islands->sleepTimeCapacity, pool->count, sizeof(float));
+	int *parent = islands->parent;
+	int *activeBodies = pool->activeBodies;
+	int activeCount = pool->activeCount;
+
+	// islands only ever join awake bodies, so nothing else needs a parent
+	for (int a = 0; a < activeCount; a++) {
+		int i = activeBodies[a];
+		parent[i] = i;
+		islands->islandSleepTime[i] = INFINITY;
+		if (!pool->awake[i]) {
+			continue;
+		}
+		bool slow = vec2LengthSquared(pool->velocity[i]) < SLEEP_LINEAR_VELOCITY * SLEEP_LINEAR_VELOCITY &&
+			fabsf(pool->angularVelocity[i]) < SLEEP_ANGULAR_VELOCITY;
+		bool stayed = pool->sleepTime[i] > 0.0f &&
+			vec2DistSquared(pool->position[i], pool->restPosition[i]) < SLEEP_LINEAR_TOLERANCE * SLEEP_LINEAR_TOLERANCE &&
+			fabsf(pool->rotation[i] - pool->restRotation[i]) < SLEEP_ANGULAR_TOLERANCE;
+		if (!stayed) {
+			// a slow body drifting along takes its resting place with it
+			pool->restPosition[i] = pool->position[i];
+			pool->restRotation[i] = pool->rotation[i];
+		}
+		pool->sleepTime[i] = slow || stayed ? pool->sleepTime[i] + deltaTime : 0.0f;
+	}
+
+	for (int i = 0; i < contacts->count; i++) {
+		collisionResult *result = &contacts->results[i];
+		if (pool->awake[result->body1] && pool->awake[result->body2]) {
+			joinIslands(parent, result->body1, result->body2);
+		}
+	}
+
+	// an island can only sleep once its most restless body can
+	for (int a = 0; a < activeCount; a++) {
+		int i = activeBodies[a];
+		if (pool->awake[i]) {
+			int root = findIslandRoot(parent, i);
+			islands->islandSleepTime[root] = fminf(islands->islandSleepTime[root], pool->sleepTime[i]);
+		}
+	}
+
+	// the active list isn't in pool order, so every sleeping island's root starts its ring first
+	// and the rest are linked in right after it
+	for (int a = 0; a < activeCount; a++) {
+		int i = activeBodies[a];
+		if (pool->awake[i] && findIslandRoot(parent, i) == i && islands->islandSleepTime[i] >= SLEEP_TIME) {
+			pool->islandId[i] = islands->nextIslandId++;
+			pool->islandNext[i] = pool->denseToSlot[i];
+		}
+	}
+	for (int a = 0; a < activeCount; a++) {
+		int i = activeBodies[a];
+		if (!pool->awake[i]) {
+			continue;
+		}
+		int root = findIslandRoot(parent, i);
+		if (islands->islandSleepTime[root] < SLEEP_TIME) {
+			continue;
+		}
+		if (i != root) {
+			pool->islandId[i] = pool->islandId[root];
+			pool->islandNext[i] = pool->islandNext[root];
+			pool->islandNext[root] = pool->denseToSlot[i];
+		}
+		setBodyAwake(pool, i, false);
+		pool->velocity[i] = (Vector2){0, 0};
+		pool->angularVelocity[i] = 0.0f;
+	}
+
+	// remember what the islands that just fell asleep were lying on
+	for (int i = 0; i < contacts->count; i++) {
+		collisionResult *result = &contacts->results[i];
+		if (!pool->awake[result->body1] && pool->objects[result->body2].isStaticBody) {
+			addRestingIsland(islands, pool, result->body2, result->body1);
+		}
+	}
+}
+
+// reorders `contacts` so every island's contacts sit next to each other. islands share no
+// dynamic bodies, so each one can be solved on its own thread. unlike updateIslands this joins
+// sleeping bodies too, a contact can still hold one in the substeps after its island fell asleep.
+// islands are numbered in the order their first contact shows up, which keeps it deterministic,
+// except that the large ones are all moved behind the small ones
+void groupContactsByIsland(islandBuilder *islands, bodyPool *pool, contactList *contacts) {
+	int count = pool->count;
+	islands->parent = growArray(islands->parent, &islands->parentCapacity, count, sizeof(int));
+	islands->rootIsland = growArray(islands->rootIsland, &islands->rootIslandCapacity, count, sizeof(int));
+	islands->contactIsland = growArray(islands->contactIsland, &islands->contactIslandCapacity, contacts->count, sizeof(int));
+	islands->groupedContacts = growArray(islands->groupedContacts, &islands->groupedCapacity, contacts->count, sizeof(collisionResult));
+	int *parent = islands->parent;
+
+	for (int i = 0; i < count; i++) {
+		parent[i] = i;
+		islands->rootIsland[i] = -1;
+	}
+	for (int i = 0; i < contacts->count; i++) {
+		collisionResult *result = &contacts->results[i];
+		if (!pool->objects[result->body2].isStaticBody) {
+			joinIslands(parent, result->body1, result->body2);
+		}
+	}
+
+	islands->islandCount = 0;
+	for (int i = 0; i < contacts->count; i++) {
+		// body1 is never the static one
+		int root = findIslandRoot(parent, contacts->results[i].body1);
+		if (islands->rootIsland[root] < 0) {
+			islands->rootIsland[root] = islands->islandCount++;
+		}
+		islands->contactIsland[i] = islands->rootIsland[root];
+	}
+
+	islands->islandStart = growArray(islands->islandStart, &islands->islandStartCapacity, islands->islandCount + 1, sizeof(int));
+	islands->islandOrder = growArray(islands->islandOrder, &islands->islandOrderCapacity, islands->islandCount, sizeof(int));
+	int *islandStart = islands->islandStart;
+	int *islandOrder = islands->islandOrder;
+	memset(islandStart, 0, (islands->islandCount + 1) * sizeof(int));
+	for (int i = 0; i < contacts->count; i++) {
+		islandStart[islands->contactIsland[i] + 1]++;
+	}
+	int nextIsland = 0;
+	for (int i = 0; i < islands->islandCount; i++) {
+		if (islandStart[i + 1] < LARGE_ISLAND_CONTACTS) {
+			islandOrder[i] = nextIsland++;
+		}
+	}
+	islands->largeIslandStart = nextIsland;
+	for (int i = 0; i < islands->islandCount; i++) {
+		if (islandStart[i + 1] >= LARGE_ISLAND_CONTACTS) {
+			islandOrder[i] = nextIsland++;
+		}
+	}
+
+	// counting sort, stable so each island keeps its contacts in detection order
+	memset(islandStart, 0, (islands->islandCount + 1) * sizeof(int));
+	for (int i = 0; i < contacts->count; i++) {
+		islands->contactIsland[i] = islandOrder[islands->contactIsland[i]];
+		islandStart[islands->contactIsland[i] + 1]++;
+	}
+	for (int i = 0; i < islands->islandCount; i++) {
+		islandStart[i + 1] += islandStart[i];
+	}
+	for (int i = 0; i < contacts->count; i++) {
+		islands->groupedContacts[islandStart[islands->contactIsland[i]]++] = contacts->results[i];
+	}
+	// the scatter moved every start up to the next island's, shift them back
+	for (int i = islands->islandCount; i > 0; i--) {
+		islandStart[i] = islandStart[i - 1];
+	}
+	islandStart[0] = 0;
+
+	// swap buffers instead of copying back
+	collisionResult *results = contacts->results;
+	int capacity = contacts->capacity;
+	contacts->results = islands->groupedContacts;
+	contacts->capacity = islands->groupedCapacity;
+	islands->groupedContacts = results;
+	islands->groupedCapacity = capacity;
+}
+
+void freeIslandBuilder(islandBuilder *islands) {
+	free(islands->parent);
+	free(islands->islandSleepTime);
+	free(islands->resting);
+	free(islands->rootIsland);
+	free(islands->contactIsland);
+	free(islands->islandStart);
+	free(islands->islandOrder);
+	free(islands->groupedContacts);
+	*islands = (islandBuilder){0};
+}
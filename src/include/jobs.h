@@ -0,0 +1,214 @@
+// never runs on more threads than this, the main thread included
+#define JOB_MAX_THREADS 32
+// jobs a single deque can hold. a parallel for only ever leaves one job per split on a deque,
+// so this is far more than the log2(count) it actually needs
+#define JOB_DEQUE_SIZE 256
+// how long an idle worker keeps looking for work before it goes to sleep. the phases of a
+// substep start right after each other, so waking up through the condition variable every
+// time would cost more than the phases themselves
+#define JOB_SPIN_COUNT 20000
+
+// runs items [begin, end) of a parallel for
+typedef void (*jobFunction)(int begin, int end, void *context);
+
+typedef struct {
+	jobFunction function;
+	void *context;
+	int begin;
+	int end;
+	int batchSize;
+} job;
+
+// chase-lev work stealing deque. the owner pushes and pops at the bottom, every other thread
+// steals from the top
+typedef struct {
+	_Alignas(64) atomic_long top;
+	_Alignas(64) atomic_long bottom;
+	job jobs[JOB_DEQUE_SIZE];
+} jobDeque;
+
+// a pool of worker threads, each with its own deque. the main thread is thread 0 and helps out
+// while it waits, so a system with one thread just runs everything inline
+typedef struct {
+	int threadCount;
+	pthread_t threads[JOB_MAX_THREADS];
+	jobDeque *deques;
+
+	atomic_int pendingItems; // items of the current parallel for that haven't run yet
+	atomic_int generation; // bumped for every parallel for so sleeping workers know to wake
+	atomic_bool running;
+	pthread_mutex_t mutex;
+	pthread_cond_t wake;
+} jobSystem;
+
+// what a worker thread gets started with
+typedef struct {
+	jobSystem *system;
+	int index;
+} jobWorker;
+
+jobWorker jobWorkers[JOB_MAX_THREADS];
+
+void pushJob(jobDeque *deque, job newJob) {
+	long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+	deque->jobs[bottom & (JOB_DEQUE_SIZE - 1)] = newJob;
+	// publishes the job to thieves, who read bottom with acquire
+	atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_release);
+}
+
+bool popJob(jobDeque *deque, job *result) {
+	long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+	atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	long top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+	if (top > bottom) {
+		atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+		return false;
+	}
+	*result = deque->jobs[bottom & (JOB_DEQUE_SIZE - 1)];
+	if (top == bottom) {
+		// the last job, a thief might be going for it too
+		bool won = atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed);
+		atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+		return won;
+	}
+	return true;
+}
+
+bool stealJob(jobDeque *deque, job *result) {
+	long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	long bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+	if (top >= bottom) {
+		return false;
+	}
+	*result = deque->jobs[top & (JOB_DEQUE_SIZE - 1)];
+	return atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed);
+}
+
+// keeps splitting the job in half, leaving the upper halves for others to steal, until it is
+// down to one batch, then runs that
+void runJob(jobSystem *system, int index, job current) {
+	while (current.end - current.begin > current.batchSize) {
+		int middle = current.begin + (current.end - current.begin) / 2;
+		job upper = current;
+		upper.begin = middle;
+		pushJob(&system->deques[index], upper);
+		current.end = middle;
+	}
+	current.function(current.begin, current.end, current.context);
+	atomic_fetch_sub_explicit(&system->pendingItems, current.end - current.begin, memory_order_acq_rel);
+}
+
+// tries this thread's own deque first, then every other one starting from the next thread
+bool findJob(jobSystem *system, int index, job *result) {
+	if (popJob(&system->deques[index], result)) {
+		return true;
+	}
+	for (int i = 1; i < system->threadCount; i++) {
+		if (stealJob(&system->deques[(index + i) % system->threadCount], result)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void runJobsUntilDone(jobSystem *system, int index) {
+	job current;
+	while (atomic_load_explicit(&system->pendingItems, memory_order_acquire) > 0) {
+		if (findJob(system, index, &current)) {
+			runJob(system, index, current);
+		} else {
+			// the last batches are still running elsewhere, don't hog a core they might need
+			sched_yield();
+		}
+	}
+}
+
+void *runJobWorker(void *argument) {
+	jobWorker *worker = argument;
+	jobSystem *system = worker->system;
+	int seenGeneration = 0;
+	for (;;) {
+		int generation = atomic_load_explicit(&system->generation, memory_order_acquire);
+		for (int spin = 0; generation == seenGeneration && spin < JOB_SPIN_COUNT; spin++) {
+			generation = atomic_load_explicit(&system->generation, memory_order_acquire);
+		}
+		if (generation == seenGeneration) {
+			pthread_mutex_lock(&system->mutex);
+			while (atomic_load(&system->generation) == seenGeneration && atomic_load(&system->running)) {
+				pthread_cond_wait(&system->wake, &system->mutex);
+			}
+			pthread_mutex_unlock(&system->mutex);
+			generation = atomic_load(&system->generation);
+		}
+		if (!atomic_load(&system->running)) {
+			return NULL;
+		}
+		seenGeneration = generation;
+		runJobsUntilDone(system, worker->index);
+	}
+}
+
+int getJobThreadCount() {
+	long processors = sysconf(_SC_NPROCESSORS_ONLN);
+	if (processors < 1) {
+		return 1;
+	}
+	return processors > JOB_MAX_THREADS ? JOB_MAX_THREADS : (int)processors;
+}
+
+// `threadCount` includes the main thread
+void startJobSystem(jobSystem *system, int threadCount) {
+	system->threadCount = threadCount;
+	system->deques = calloc(threadCount, sizeof(jobDeque));
+	atomic_store(&system->pendingItems, 0);
+	atomic_store(&system->generation, 0);
+	atomic_store(&system->running, true);
+	pthread_mutex_init(&system->mutex, NULL);
+	pthread_cond_init(&system->wake, NULL);
+	for (int i = 1; i < threadCount; i++) {
+		jobWorkers[i] = (jobWorker){system, i};
+		pthread_create(&system->threads[i], NULL, runJobWorker, &jobWorkers[i]);
+	}
+}
+
+void stopJobSystem(jobSystem *system) {
+	if (system->deques == NULL) {
+		return;
+	}
+	pthread_mutex_lock(&system->mutex);
+	atomic_store(&system->running, false);
+	pthread_cond_broadcast(&system->wake);
+	pthread_mutex_unlock(&system->mutex);
+	for (int i = 1; i < system->threadCount; i++) {
+		pthread_join(system->threads[i], NULL);
+	}
+	pthread_mutex_destroy(&system->mutex);
+	pthread_cond_destroy(&system->wake);
+	free(system->deques);
+	system->deques = NULL;
+	system->threadCount = 0;
+}
+
+// calls `function` over [0, count) in batches of at most `batchSize` items, spread over every
+// thread, and returns once all of them are done. batches must not touch each other's data.
+// small loops and systems that were never started just run inline on the calling thread
+void parallelFor(jobSystem *system, int count, int batchSize, jobFunction function, void *context) {
+	if (count <= 0) {
+		return;
+	}
+	if (system->threadCount <= 1 || count <= batchSize) {
+		function(0, count, context);
+		return;
+	}
+
+	atomic_store_explicit(&system->pendingItems, count, memory_order_release);
+	pushJob(&system->deques[0], (job){function, context, 0, count, batchSize});
+	pthread_mutex_lock(&system->mutex);
+	atomic_fetch_add_explicit(&system->generation, 1, memory_order_acq_rel);
+	pthread_cond_broadcast(&system->wake);
+	pthread_mutex_unlock(&system->mutex);
+
+	runJobsUntilDone(system, 0);
+}
@@ -1,48 +1,131 @@
 
 
 
+// circles and capsules are stored like polygons with one and two points, grown outwards by a
+// radius. that keeps transforms, boxes and the broadphase the same for every shape
+typedef enum {
+	SHAPE_POLYGON,
+	SHAPE_BOX, // a polygon that's known to be a rectangle from getRectPrototype
+	SHAPE_CIRCLE,
+	SHAPE_CAPSULE,
+	SHAPE_TYPE_COUNT
+} shapeType;
+
+// immutable geometry, worked out once and shared by every body with the same shape
 typedef struct {
+	shapeType type;
+	float radius; // 0 for polygons
+	Vector2 halfExtents; // boxes only
 	int numPoints;
-	Vector2 *pointArray;
+	Vector2 *pointArray; // local space
+	Vector2 *edgeNormals; // unit length, local space, pointing out of edge pointArray[i] -> pointArray[i + 1]
+	// the edge normals' angles in ascending order and which edge each one belongs to,
+	// for finding support points with a binary search
+	float *normalAngles;
+	int *normalAngleEdges;
+	float area;
+	float inertia;
+	// bodies using a shared prototype, it's freed when the last of them is destroyed.
+	// -1 for prototypes from createShapePrototype, those live as long as the cache
+	int references;
+	unsigned int keyHash; // where a shared prototype sits in the cache's table
+} shapePrototype;
+
+// support point queries remember where they ended up for this many ranges of directions
+#define SUPPORT_CACHE_BUCKETS 8
+
+// a body's instance of a prototype, only the world space points are its own
+typedef struct {
+	shapeType type; // copied from the prototype
+	float radius;
+	int numPoints;
+	Vector2 *pointArray; // the prototype's
 	Vector2 *globalPointArray;
+	Vector2 *globalEdgeNormals; // the prototype's edge normals rotated into world space
+	// the same world space points split into x and y, padded for the SAT kernel
+	float *globalX;
+	float *globalY;
+	int paddedNumPoints;
+	// the last support point found in each direction bucket, -1 if there isn't one yet.
+	// shapes are shared between pairs tested on different threads, so these are relaxed atomics.
+	// any valid vertex is a fine place to start, but where two points tie the start decides which
+	// one comes back, so the results depend on whose write won. setDeterministicMode turns it off
+	atomic_int supportCache[SUPPORT_CACHE_BUCKETS];
+	const shapePrototype *prototype;
 } polygonCollisionShape;
 
+// the parts of a body the simulation rarely touches.
+// position, velocity, rotation (thank god it's 2d), inverse mass and the AABB live in the
+// bodyPool's per-field arrays
 typedef struct {
 	float staticFriction;
 	float dynamicFriction;
 	float mass;
 	float inertia;
-	float invMass;
-	float invInertia;
-	Vector2 position;
-	Vector2 velocity;
-	float angularVelocity;
-	float rotation; // thank god it's 2d
 	float gravityStrength;
 	bool isStaticBody;
-	AABB box;
 	polygonCollisionShape *collisionShape;
 } physicsObject;
 
+// identifies the pair of features (a vertex of one shape against an edge of the other) that
+// produced a contact point, so the point can be matched up again on the next step
+typedef unsigned int contactFeature;
+
+contactFeature makeContactFeature(int vertexShape, int vertexIndex, int edgeIndex) {
+	return ((unsigned int)vertexShape << 31) | ((unsigned int)vertexIndex << 16) | (unsigned int)edgeIndex;
+}
+
+// an edge normal of one of the two shapes in a SAT test, shape is 0 or 1 (-1 if there isn't one)
+typedef struct {
+	int shape;
+	int edge;
+} separatingAxis;
+
 typedef struct {
 	Vector2 normal;
 	Vector2 contact1;
 	Vector2 contact2;
+	contactFeature feature1;
+	contactFeature feature2;
+	// how deep each contact point is on its own, penetrationDepth is the deepest of them
+	float depth1;
+	float depth2;
 	int numContacts;
 	float penetrationDepth;
 	bool isCollided;
-	physicsObject *object1;
-	physicsObject *object2;
+	// which two bodies collided, all set by the caller
+	int body1;
+	int body2;
+	unsigned long long pairKey;
+	// where each contact point sat on both bodies when it was found, in their local space. lets
+	// the substeps between two collision detections follow the contact as the bodies move
+	Vector2 localAnchor1[2];
+	Vector2 localAnchor2[2];
+	float anchoredDepth[2];
 } collisionResult;
 
-float getPolygonInertia(polygonCollisionShape *poly) {
+// every collision the narrowphase found this substep, waiting to be solved
+typedef struct {
+	collisionResult *results;
+	int count;
+	int capacity;
+} contactList;
+
+// what the narrowphase made of one broadphase pair. worker threads fill these in, the results
+// get committed afterwards in pair order
+typedef struct {
+	collisionResult result;
+	separatingAxis axis;
+	bool tested; // false if the pair was skipped before running any collider
+} pairCollision;
+
+float getPolygonInertia(Vector2 *points, int numPoints) {
 
-	Vector2 *points = poly->pointArray;
 	float inertia = 0;
 
-	for (int i = 0; i < poly->numPoints; i++) {
+	for (int i = 0; i < numPoints; i++) {
 		Vector2 point1 = points[i];
-		Vector2 point2 = points[(i + 1) % poly->numPoints];
+		Vector2 point2 = points[(i + 1) % numPoints];
 
 		float term1 = vec2Cross(point1, point1) + vec2Cross(point2, point2);
 		float term2 = vec2Cross(point1, point2);
@@ -0,0 +1,263 @@
+// shared prototypes in the cache's table start out with at most this many slots
+#define PROTOTYPE_TABLE_MIN_CAPACITY 64
+// sizes are rounded to this many steps per pixel before they're compared, so sizes that only
+// differ by float noise end up sharing a prototype
+#define PROTOTYPE_KEY_SCALE 1024.0f
+
+// a shared prototype's type and size, with the size quantized by PROTOTYPE_KEY_SCALE
+typedef struct {
+	shapeType type;
+	long long x;
+	long long y;
+} prototypeKey;
+
+typedef struct {
+	prototypeKey key;
+	shapePrototype *prototype; // NULL for an empty slot
+} prototypeTableEntry;
+
+// owns every shape prototype. prototypes never change once created.
+// rectangles, circles and capsules are shared between everything of the same type and size,
+// found through an open addressed hash table, and freed once no body uses them anymore.
+// anything else from createShapePrototype lives in an arena until the world is torn down
+typedef struct {
+	memoryArena arena;
+	prototypeTableEntry *table; // linear probing, capacity is a power of two
+	int tableCount;
+	int tableCapacity;
+} shapePrototypeCache;
+
+float getPolygonSignedArea(Vector2 *points, int numPoints) {
+	float area = 0.0f;
+	for (int i = 0; i < numPoints; i++) {
+		area += vec2Cross(points[i], points[(i + 1) % numPoints]);
+	}
+	return area * 0.5f;
+}
+
+// bytes a prototype takes up with all of its arrays right behind it
+size_t getShapePrototypeSize(int numPoints) {
+	return sizeof(shapePrototype) + (size_t)numPoints * (2 * sizeof(Vector2) + sizeof(float) + sizeof(int));
+}
+
+// copies the points into the memory behind the prototype and works out everything about them
+// that doesn't depend on the body
+void buildShapePrototype(shapePrototype *prototype, Vector2 *points, int numPoints) {
+	prototype->type = SHAPE_POLYGON;
+	prototype->radius = 0.0f;
+	prototype->halfExtents = (Vector2){0.0f, 0.0f};
+	prototype->numPoints = numPoints;
+	prototype->pointArray = (Vector2 *)(prototype + 1);
+	prototype->edgeNormals = prototype->pointArray + numPoints;
+	prototype->normalAngles = (float *)(prototype->edgeNormals + numPoints);
+	prototype->normalAngleEdges = (int *)(prototype->normalAngles + numPoints);
+	prototype->references = -1;
+	prototype->keyHash = 0;
+	memcpy(prototype->pointArray, points, (size_t)numPoints * sizeof(Vector2));
+
+	float signedArea = getPolygonSignedArea(points, numPoints);
+	for (int i = 0; i < numPoints; i++) {
+		Vector2 edge = vec2Sub(points[(i + 1) % numPoints], points[i]);
+		// which side is "out" depends on the winding
+		Vector2 normal = signedArea > 0.0f ? (Vector2){edge.y, -edge.x} : vec2Perp(edge);
+		// a circle's single point has no edge to speak of
+		prototype->edgeNormals[i] = vec2IsZeroApprox(normal) ? (Vector2){1.0f, 0.0f} : vec2Normalize(normal);
+	}
+	// the normals already go around in order, so the sort only has to undo the wrap past -pi
+	for (int i = 0; i < numPoints; i++) {
+		float angle = atan2f(prototype->edgeNormals[i].y, prototype->edgeNormals[i].x);
+		int j = i;
+		while (j > 0 && prototype->normalAngles[j - 1] > angle) {
+			prototype->normalAngles[j] = prototype->normalAngles[j - 1];
+			prototype->normalAngleEdges[j] = prototype->normalAngleEdges[j - 1];
+			j--;
+		}
+		prototype->normalAngles[j] = angle;
+		prototype->normalAngleEdges[j] = i;
+	}
+	prototype->area = fabsf(signedArea);
+	prototype->inertia = getPolygonInertia(points, numPoints);
+}
+
+// a prototype that isn't shared with anything, it stays around until the cache is freed
+shapePrototype *createShapePrototype(shapePrototypeCache *cache, Vector2 *points, int numPoints) {
+	shapePrototype *prototype = arenaAlloc(&cache->arena, getShapePrototypeSize(numPoints), _Alignof(shapePrototype));
+	buildShapePrototype(prototype, points, numPoints);
+	return prototype;
+}
+
+prototypeKey makePrototypeKey(shapeType type, Vector2 dimensions) {
+	return (prototypeKey){type, llroundf(dimensions.x * PROTOTYPE_KEY_SCALE), llroundf(dimensions.y * PROTOTYPE_KEY_SCALE)};
+}
+
+unsigned int hashPrototypeKey(prototypeKey key) {
+	unsigned long long hash = (unsigned long long)key.type * 0x9e3779b97f4a7c15ull;
+	hash = (hash ^ (unsigned long long)key.x) * 0xbf58476d1ce4e5b9ull;
+	hash = (hash ^ (unsigned long long)key.y) * 0x94d049bb133111ebull;
+	return (unsigned int)(hash ^ (hash >> 32));
+}
+
+bool prototypeKeysEqual(prototypeKey a, prototypeKey b) {
+	return a.type == b.type && a.x == b.x && a.y == b.y;
+}
+
+shapePrototype *findKeyedPrototype(shapePrototypeCache *cache, prototypeKey key) {
+	if (cache->tableCount == 0) {
+		return NULL;
+	}
+	unsigned int mask = (unsigned int)cache->tableCapacity - 1;
+	for (unsigned int slot = hashPrototypeKey(key) & mask; cache->table[slot].prototype != NULL; slot = (slot + 1) & mask) {
+		if (prototypeKeysEqual(cache->table[slot].key, key)) {
+			return cache->table[slot].prototype;
+		}
+	}
+	return NULL;
+}
+
+void insertPrototypeEntry(prototypeTableEntry *table, int capacity, prototypeTableEntry entry) {
+	unsigned int mask = (unsigned int)capacity - 1;
+	unsigned int slot = entry.prototype->keyHash & mask;
+	while (table[slot].prototype != NULL) {
+		slot = (slot + 1) & mask;
+	}
+	table[slot] = entry;
+}
+
+// keeps the table at most half full
+void addKeyedPrototype(shapePrototypeCache *cache, prototypeKey key, shapePrototype *prototype) {
+	if ((cache->tableCount + 1) * 2 > cache->tableCapacity) {
+		int capacity = cache->tableCapacity > 0 ? cache->tableCapacity * 2 : PROTOTYPE_TABLE_MIN_CAPACITY;
+		prototypeTableEntry *table = calloc(capacity, sizeof(prototypeTableEntry));
+		if (table == NULL) {
+			fprintf(stderr, "shart2D: out of memory growing the prototype table\n");
+			exit(1);
+		}
+		for (int i = 0; i < cache->tableCapacity; i++) {
+			if (cache->table[i].prototype != NULL) {
+				insertPrototypeEntry(table, capacity, cache->table[i]);
+			}
+		}
+		free(cache->table);
+		cache->table = table;
+		cache->tableCapacity = capacity;
+	}
+	prototype->keyHash = hashPrototypeKey(key);
+	prototype->references = 0;
+	insertPrototypeEntry(cache->table, cache->tableCapacity, (prototypeTableEntry){key, prototype});
+	cache->tableCount++;
+}
+
+// takes the prototype out of the table, shifting back any entry further along the probe run
+// that could have gone in its slot, so lookups never need tombstones
+void removeKeyedPrototype(shapePrototypeCache *cache, shapePrototype *prototype) {
+	unsigned int mask = (unsigned int)cache->tableCapacity - 1;
+	unsigned int slot = prototype->keyHash & mask;
+	while (cache->table[slot].prototype != prototype) {
+		slot = (slot + 1) & mask;
+	}
+	unsigned int next = slot;
+	for (;;) {
+		next = (next + 1) & mask;
+		shapePrototype *moving = cache->table[next].prototype;
+		if (moving == NULL) {
+			break;
+		}
+		// only move it if its home slot isn't between the hole and where it sits now
+		unsigned int home = moving->keyHash & mask;
+		if (((next - home) & mask) >= ((next - slot) & mask)) {
+			cache->table[slot] = cache->table[next];
+			slot = next;
+		}
+	}
+	cache->table[slot] = (prototypeTableEntry){0};
+	cache->tableCount--;
+}
+
+// a shared prototype gets its own block of memory so it can be freed on its own
+shapePrototype *createKeyedPrototype(shapePrototypeCache *cache, prototypeKey key, Vector2 *points, int numPoints) {
+	shapePrototype *prototype = malloc(getShapePrototypeSize(numPoints));
+	if (prototype == NULL) {
+		fprintf(stderr, "shart2D: out of memory allocating a shape prototype\n");
+		exit(1);
+	}
+	buildShapePrototype(prototype, points, numPoints);
+	addKeyedPrototype(cache, key, prototype);
+	return prototype;
+}
+
+// a body started using the prototype
+void retainShapePrototype(shapePrototype *prototype) {
+	if (prototype->references >= 0) {
+		prototype->references++;
+	}
+}
+
+// a body using the prototype is gone, shared prototypes are freed along with their last body
+void releaseShapePrototype(shapePrototypeCache *cache, shapePrototype *prototype) {
+	if (prototype->references < 0 || --prototype->references > 0) {
+		return;
+	}
+	removeKeyedPrototype(cache, prototype);
+	free(prototype);
+}
+
+// the shared prototype for a rectangle of this size, created the first time it's asked for
+shapePrototype *getRectPrototype(shapePrototypeCache *cache, Vector2 dimensions) {
+	prototypeKey key = makePrototypeKey(SHAPE_BOX, dimensions);
+	shapePrototype *prototype = findKeyedPrototype(cache, key);
+	if (prototype != NULL) {
+		return prototype;
+	}
+
+	Vector2 points[4] = {
+		(Vector2){dimensions.x * -0.5f, dimensions.y * -0.5f}, // top left
+		(Vector2){dimensions.x * -0.5f, dimensions.y * 0.5f}, // bottom left
+		(Vector2){dimensions.x * 0.5f, dimensions.y * 0.5f}, // bottom right
+		(Vector2){dimensions.x * 0.5f, dimensions.y * -0.5f} // top right
+	};
+	// the box collider relies on this order, see BOX_EDGE_LEFT and friends
+	prototype = createKeyedPrototype(cache, key, points, 4);
+	prototype->type = SHAPE_BOX;
+	prototype->halfExtents = vec2Scale(dimensions, 0.5f);
+	return prototype;
+}
+
+// a circle is one point at the center, a capsule is a segment of `length` along the local x axis.
+// both get grown by `radius`
+shapePrototype *getRoundPrototype(shapePrototypeCache *cache, shapeType type, float length, float radius) {
+	prototypeKey key = makePrototypeKey(type, (Vector2){length, radius});
+	shapePrototype *prototype = findKeyedPrototype(cache, key);
+	if (prototype != NULL) {
+		return prototype;
+	}
+
+	Vector2 points[2] = {
+		(Vector2){length * -0.5f, 0.0f},
+		(Vector2){length * 0.5f, 0.0f}
+	};
+	prototype = createKeyedPrototype(cache, key, points, type == SHAPE_CIRCLE ? 1 : 2);
+	prototype->type = type;
+	prototype->radius = radius;
+	prototype->area = PI * radius * radius + length * radius * 2.0f;
+	// the same scale getPolygonInertia gives polygons, so mixed shapes spin alike
+	prototype->inertia = prototype->area / 6.0f;
+	return prototype;
+}
+
+shapePrototype *getCirclePrototype(shapePrototypeCache *cache, float radius) {
+	return getRoundPrototype(cache, SHAPE_CIRCLE, 0.0f, radius);
+}
+
+// `length` is the distance between the centers of the two end caps
+shapePrototype *getCapsulePrototype(shapePrototypeCache *cache, float length, float radius) {
+	return getRoundPrototype(cache, SHAPE_CAPSULE, length, radius);
+}
+
+void freeShapePrototypeCache(shapePrototypeCache *cache) {
+	freeArena(&cache->arena);
+	for (int i = 0; i < cache->tableCapacity; i++) {
+		free(cache->table[i].prototype);
+	}
+	free(cache->table);
+	*cache = (shapePrototypeCache){0};
+}
@@ -0,0 +1,115 @@
+// the table never gets fuller than this before it's rebuilt
+#define SAT_CACHE_MAX_LOAD 0.5f
+#define SAT_CACHE_EMPTY_KEY 0xffffffffffffffffull
+
+// the axis a pair was last tested on, stored against the body ids (see getBodyId) rather than
+// the order the pair came out of the broadphase in
+typedef struct {
+	unsigned long long pairKey; // lower id first
+	unsigned int axisBody; // id of the body whose edge the axis is
+	int axisEdge;
+	unsigned int lastUsed;
+} separatingAxisEntry;
+
+// open addressing hash table from a pair to the axis that last seperated it (or overlapped the
+// least), so with substeps a pair that stays apart usually only costs one projection.
+// entries are never removed one at a time, pairs that stop being tested are dropped whenever
+// the table gets rebuilt
+typedef struct {
+	separatingAxisEntry *entries;
+	int capacity; // always a power of two
+	int count;
+	unsigned int step;
+} separatingAxisCache;
+
+unsigned int hashPairKey(unsigned long long key) {
+	key ^= key >> 33;
+	key *= 0xff51afd7ed558ccdull;
+	key ^= key >> 33;
+	return (unsigned int)key;
+}
+
+separatingAxisEntry *probeSeparatingAxisCache(separatingAxisEntry *entries, int capacity, unsigned long long pairKey) {
+	unsigned int mask = (unsigned int)capacity - 1;
+	unsigned int i = hashPairKey(pairKey) & mask;
+	while (entries[i].pairKey != pairKey && entries[i].pairKey != SAT_CACHE_EMPTY_KEY) {
+		i = (i + 1) & mask;
+	}
+	return &entries[i];
+}
+
+// moves every entry used this step or the one before into a table big enough for `needed`
+void rebuildSeparatingAxisCache(separatingAxisCache *cache, int needed) {
+	int liveCount = 0;
+	for (int i = 0; i < cache->capacity; i++) {
+		separatingAxisEntry *entry = &cache->entries[i];
+		if (entry->pairKey != SAT_CACHE_EMPTY_KEY && cache->step - entry->lastUsed <= 1) {
+			liveCount++;
+		}
+	}
+	int capacity = 64;
+	while (capacity * SAT_CACHE_MAX_LOAD < (liveCount > needed ? liveCount : needed) * 2) {
+		capacity *= 2;
+	}
+
+	separatingAxisEntry *entries = malloc((size_t)capacity * sizeof(separatingAxisEntry));
+	if (entries == NULL) {
+		fprintf(stderr, "shart2D: out of memory growing the separating axis cache\n");
+		exit(1);
+	}
+	for (int i = 0; i < capacity; i++) {
+		entries[i].pairKey = SAT_CACHE_EMPTY_KEY;
+	}
+	for (int i = 0; i < cache->capacity; i++) {
+		separatingAxisEntry *entry = &cache->entries[i];
+		if (entry->pairKey != SAT_CACHE_EMPTY_KEY && cache->step - entry->lastUsed <= 1) {
+			*probeSeparatingAxisCache(entries, capacity, entry->pairKey) = *entry;
+		}
+	}
+	free(cache->entries);
+	cache->entries = entries;
+	cache->capacity = capacity;
+	cache->count = liveCount;
+}
+
+// call once per step before looking anything up, so pairs that went unused can age out
+void beginSeparatingAxisStep(separatingAxisCache *cache) {
+	cache->step++;
+}
+
+// the cached axis for a pair seen from body1's side, or none if the pair is new
+separatingAxis getCachedSeparatingAxis(separatingAxisCache *cache, unsigned int body1, unsigned int body2) {
+	separatingAxis axis = {-1, 0};
+	if (cache->count == 0) {
+		return axis;
+	}
+	separatingAxisEntry *entry = probeSeparatingAxisCache(cache->entries, cache->capacity, makePairKey(body1, body2));
+	if (entry->pairKey != SAT_CACHE_EMPTY_KEY) {
+		axis.shape = entry->axisBody == body1 ? 0 : 1;
+		axis.edge = entry->axisEdge;
+	}
+	return axis;
+}
+
+void storeSeparatingAxis(separatingAxisCache *cache, unsigned int body1, unsigned int body2, separatingAxis axis) {
+	if (axis.shape < 0) {
+		return;
+	}
+	if ((cache->count + 1) > cache->capacity * SAT_CACHE_MAX_LOAD) {
+		rebuildSeparatingAxisCache(cache, cache->count + 1);
+	}
+	unsigned long long pairKey = makePairKey(body1, body2);
+	separatingAxisEntry *entry = probeSeparatingAxisCache(cache->entries, cache->capacity, pairKey);
+	if (entry->pairKey == SAT_CACHE_EMPTY_KEY) {
+		entry->pairKey = pairKey;
+		cache->count++;
+	}
+	entry->axisBody = axis.shape == 0 ? body1 : body2;
+	entry->axisEdge = axis.edge;
+	entry->lastUsed = cache->step;
+}
+
+void freeSeparatingAxisCache(separatingAxisCache *cache) {
+	free(cache->entries);
+	*cache = (separatingAxisCache){0};
+}
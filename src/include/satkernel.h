@@ -0,0 +1,95 @@
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// world space points are also kept as separate x[] and y[] arrays padded to a multiple of this,
+// so the kernel below never needs a scalar tail loop. the padding repeats the first point, which
+// can't change a min or a max
+#define SAT_POINT_PADDING 8
+// how many axes get projected at once
+#define SAT_AXIS_BATCH 4
+
+int getPaddedPointCount(int numPoints) {
+	return (numPoints + SAT_POINT_PADDING - 1) / SAT_POINT_PADDING * SAT_POINT_PADDING;
+}
+
+#if defined(__SSE2__)
+float horizontalMin(__m128 v) {
+	v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+	v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+	return _mm_cvtss_f32(v);
+}
+
+float horizontalMax(__m128 v) {
+	v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+	v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+	return _mm_cvtss_f32(v);
+}
+#endif
+
+// projects every point onto SAT_AXIS_BATCH axes at once and writes the extremes along each.
+// a whole batch of points is loaded per iteration and dotted against every axis in the batch
+void projectPointsOntoAxes(const float *x, const float *y, int paddedCount,
+		const float *axisX, const float *axisY, float *min, float *max) {
+#if defined(__AVX__)
+	__m256 minimum[SAT_AXIS_BATCH];
+	__m256 maximum[SAT_AXIS_BATCH];
+	__m256 directionX[SAT_AXIS_BATCH];
+	__m256 directionY[SAT_AXIS_BATCH];
+	for (int a = 0; a < SAT_AXIS_BATCH; a++) {
+		minimum[a] = _mm256_set1_ps(INFINITY);
+		maximum[a] = _mm256_set1_ps(-INFINITY);
+		directionX[a] = _mm256_set1_ps(axisX[a]);
+		directionY[a] = _mm256_set1_ps(axisY[a]);
+	}
+	for (int i = 0; i < paddedCount; i += 8) {
+		__m256 pointX = _mm256_loadu_ps(x + i);
+		__m256 pointY = _mm256_loadu_ps(y + i);
+		for (int a = 0; a < SAT_AXIS_BATCH; a++) {
+			__m256 dotProduct = _mm256_add_ps(_mm256_mul_ps(pointX, directionX[a]), _mm256_mul_ps(pointY, directionY[a]));
+			minimum[a] = _mm256_min_ps(minimum[a], dotProduct);
+			maximum[a] = _mm256_max_ps(maximum[a], dotProduct);
+		}
+	}
+	for (int a = 0; a < SAT_AXIS_BATCH; a++) {
+		min[a] = horizontalMin(_mm_min_ps(_mm256_castps256_ps128(minimum[a]), _mm256_extractf128_ps(minimum[a], 1)));
+		max[a] = horizontalMax(_mm_max_ps(_mm256_castps256_ps128(maximum[a]), _mm256_extractf128_ps(maximum[a], 1)));
+	}
+#elif defined(__SSE2__)
+	__m128 minimum[SAT_AXIS_BATCH];
+	__m128 maximum[SAT_AXIS_BATCH];
+	__m128 directionX[SAT_AXIS_BATCH];
+	__m128 directionY[SAT_AXIS_BATCH];
+	for (int a = 0; a < SAT_AXIS_BATCH; a++) {
+		minimum[a] = _mm_set1_ps(INFINITY);
+		maximum[a] = _mm_set1_ps(-INFINITY);
+		directionX[a] = _mm_set1_ps(axisX[a]);
+		directionY[a] = _mm_set1_ps(axisY[a]);
+	}
+	for (int i = 0; i < paddedCount; i += 4) {
+		__m128 pointX = _mm_loadu_ps(x + i);
+		__m128 pointY = _mm_loadu_ps(y + i);
+		for (int a = 0; a < SAT_AXIS_BATCH; a++) {
+			__m128 dotProduct = _mm_add_ps(_mm_mul_ps(pointX, directionX[a]), _mm_mul_ps(pointY, directionY[a]));
+			minimum[a] = _mm_min_ps(minimum[a], dotProduct);
+			maximum[a] = _mm_max_ps(maximum[a], dotProduct);
+		}
+	}
+	for (int a = 0; a < SAT_AXIS_BATCH; a++) {
+		min[a] = horizontalMin(minimum[a]);
+		max[a] = horizontalMax(maximum[a]);
+	}
+#else
+	for (int a = 0; a < SAT_AXIS_BATCH; a++) {
+		min[a] = INFINITY;
+		max[a] = -INFINITY;
+	}
+	for (int i = 0; i < paddedCount; i++) {
+		for (int a = 0; a < SAT_AXIS_BATCH; a++) {
+			float dotProduct = (x[i] * axisX[a]) + (y[i] * axisY[a]);
+			if (dotProduct < min[a]) min[a] = dotProduct;
+			if (dotProduct > max[a]) max[a] = dotProduct;
+		}
+	}
+#endif
+}
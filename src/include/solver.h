@@ -0,0 +1,609 @@
+// TODO: put this inside of the physicsObject
+#define CONTACT_ELASTICITY 0.5f
+// approach speeds below this don't bounce, otherwise resting stacks never settle
+#define RESTITUTION_VELOCITY_THRESHOLD 1.0f
+// penetration allowed to stay, keeps resting contacts touching between steps
+#define POSITION_SLOP 0.01f
+// fraction of the penetration past the slop pushed out per substep
+#define POSITION_CORRECTION_FACTOR 0.2f
+// fastest the position correction may push bodies apart, in units per frame
+#define MAX_CORRECTION_VELOCITY 5.0f
+// two point contacts whose points push on the bodies in nearly the same way (the condition
+// number of their mass matrix is past this) are solved one point at a time instead
+#define MAX_BLOCK_CONDITION 1000.0f
+// colours a large island's constraints can be split into. constraints that don't fit in any of
+// them go into one extra overflow colour, which has to be solved on a single thread
+#define GRAPH_COLOR_COUNT 24
+#define GRAPH_OVERFLOW_COLOR GRAPH_COLOR_COUNT
+
+// the same key whichever way round the two are given
+unsigned long long makePairKey(unsigned int id1, unsigned int id2) {
+	if (id1 > id2) {
+		unsigned int temp = id1;
+		id1 = id2;
+		id2 = temp;
+	}
+	return ((unsigned long long)id1 << 32) | id2;
+}
+
+// impulses a contact point ended the last step with
+typedef struct {
+	contactFeature feature;
+	float normalImpulse;
+	float tangentImpulse;
+} cachedImpulse;
+
+// everything kept about a touching pair between steps
+typedef struct {
+	unsigned long long pairKey;
+	int numContacts;
+	cachedImpulse impulses[2];
+} contactManifold;
+
+typedef struct {
+	Vector2 r1; // from each body's center to the contact point
+	Vector2 r2;
+	float normalMass;
+	float tangentMass;
+	float velocityBias; // target bounce speed along the normal
+	float positionBias; // target pseudo velocity along the normal
+	float normalImpulse; // accumulated over the iterations
+	float tangentImpulse;
+	float pseudoImpulse;
+	contactFeature feature;
+} solverContactPoint;
+
+typedef struct {
+	int body1;
+	int body2;
+	Vector2 normal; // points from body2 towards body1
+	Vector2 tangent;
+	float staticFriction;
+	float dynamicFriction;
+	int numContacts;
+	solverContactPoint points[2];
+	// both normal impulses of a two point contact are solved together, with this matrix (how
+	// much each point's impulse changes both points' velocities) and its inverse
+	bool blockSolve;
+	float normalMatrix[2][2];
+	float blockNormalMass[2][2];
+	unsigned long long pairKey;
+} contactConstraint;
+
+// sequential impulse solver.
+// impulses are accumulated and clamped across iterations instead of being applied once per
+// contact, and each step starts from the impulses the same contact points ended the last step with.
+// penetration is fixed with split impulses: a second set of impulses solved the same way, but on
+// pseudo velocities that only move the bodies and are thrown away afterwards, so pushing bodies
+// apart never adds real velocity to them
+typedef struct {
+	contactConstraint *constraints;
+	int count;
+	int capacity;
+
+	// constraints [colorStart[c], colorStart[c + 1]) have colour c, see colorConstraints
+	int colorStart[GRAPH_COLOR_COUNT + 2];
+	unsigned int *bodyColors; // per body, a bit for every colour it already has a constraint in
+	int bodyColorCapacity;
+	int *constraintColor;
+	int constraintColorCapacity;
+	contactConstraint *coloredConstraints;
+	int coloredCapacity;
+
+	// per body, indexed like the pool
+	Vector2 *pseudoVelocity;
+	int pseudoVelocityCapacity;
+	float *pseudoAngularVelocity;
+	int pseudoAngularVelocityCapacity;
+
+	// last step's manifolds, sorted by pairKey
+	contactManifold *manifolds;
+	int manifoldCount;
+	int manifoldCapacity;
+} contactSolver;
+
+contactManifold *findContactManifold(contactSolver *solver, unsigned long long pairKey) {
+	int low = 0;
+	int high = solver->manifoldCount - 1;
+	while (low <= high) {
+		int middle = (low + high) / 2;
+		unsigned long long key = solver->manifolds[middle].pairKey;
+		if (key == pairKey) {
+			return &solver->manifolds[middle];
+		} else if (key < pairKey) {
+			low = middle + 1;
+		} else {
+			high = middle - 1;
+		}
+	}
+	return NULL;
+}
+
+// velocity of the contact point on body1 relative to the one on body2
+Vector2 getContactRelativeVelocity(bodyPool *pool, contactConstraint *constraint, solverContactPoint *point) {
+	int body1 = constraint->body1;
+	int body2 = constraint->body2;
+	return vec2Sub(
+		vec2Add(pool->velocity[body1], vec2Scale(vec2Perp(point->r1), pool->angularVelocity[body1])),
+		vec2Add(pool->velocity[body2], vec2Scale(vec2Perp(point->r2), pool->angularVelocity[body2]))
+	);
+}
+
+// body1 is never static. body2 can be, and is left alone then: islands get solved on different
+// threads and a static body like the floor is shared between them
+void applyContactImpulse(bodyPool *pool, contactConstraint *constraint, solverContactPoint *point, Vector2 impulse) {
+	int body1 = constraint->body1;
+	int body2 = constraint->body2;
+	pool->velocity[body1] = vec2Add(pool->velocity[body1], vec2Scale(impulse, pool->invMass[body1]));
+	pool->angularVelocity[body1] += vec2Cross(point->r1, impulse) * pool->invInertia[body1];
+	if (pool->invMass[body2] > 0.0f) {
+		pool->velocity[body2] = vec2Sub(pool->velocity[body2], vec2Scale(impulse, pool->invMass[body2]));
+		pool->angularVelocity[body2] -= vec2Cross(point->r2, impulse) * pool->invInertia[body2];
+	}
+}
+
+float getEffectiveMass(bodyPool *pool, int body1, int body2, Vector2 r1, Vector2 r2, Vector2 direction) {
+	float r1PerpDotDirection = vec2Dot(vec2Perp(r1), direction);
+	float r2PerpDotDirection = vec2Dot(vec2Perp(r2), direction);
+	float inverseMass = (pool->invMass[body1] + pool->invMass[body2]) +
+		((r1PerpDotDirection * r1PerpDotDirection) * pool->invInertia[body1]) +
+		((r2PerpDotDirection * r2PerpDotDirection) * pool->invInertia[body2]);
+	return inverseMass > 0.0f ? 1.0f / inverseMass : 0.0f;
+}
+
+Vector2 rotateByOrientation(Vector2 v, Vector2 orientation) {
+	return (Vector2){v.x * orientation.x - v.y * orientation.y, v.x * orientation.y + v.y * orientation.x};
+}
+
+Vector2 unrotateByOrientation(Vector2 v, Vector2 orientation) {
+	return (Vector2){v.x * orientation.x + v.y * orientation.y, v.y * orientation.x - v.x * orientation.y};
+}
+
+// sets up solving both normal impulses of a two point contact at once. one at a time, the first
+// point takes the whole impact of a box landing flat and the second has to undo the spin that
+// gives it, which takes many more iterations than there are
+void prepareBlockSolve(bodyPool *pool, contactConstraint *constraint) {
+	constraint->blockSolve = false;
+	if (constraint->numContacts != 2) {
+		return;
+	}
+	int body1 = constraint->body1;
+	int body2 = constraint->body2;
+	float inverseMass = pool->invMass[body1] + pool->invMass[body2];
+	float invInertia1 = pool->invInertia[body1];
+	float invInertia2 = pool->invInertia[body2];
+	solverContactPoint *point1 = &constraint->points[0];
+	solverContactPoint *point2 = &constraint->points[1];
+	float r1Normal1 = vec2Cross(point1->r1, constraint->normal);
+	float r2Normal1 = vec2Cross(point1->r2, constraint->normal);
+	float r1Normal2 = vec2Cross(point2->r1, constraint->normal);
+	float r2Normal2 = vec2Cross(point2->r2, constraint->normal);
+
+	float k11 = inverseMass + invInertia1 * r1Normal1 * r1Normal1 + invInertia2 * r2Normal1 * r2Normal1;
+	float k22 = inverseMass + invInertia1 * r1Normal2 * r1Normal2 + invInertia2 * r2Normal2 * r2Normal2;
+	float k12 = inverseMass + invInertia1 * r1Normal1 * r1Normal2 + invInertia2 * r2Normal1 * r2Normal2;
+	float determinant = k11 * k22 - k12 * k12;
+	if (k11 * k11 >= MAX_BLOCK_CONDITION * determinant) {
+		return;
+	}
+	constraint->blockSolve = true;
+	constraint->normalMatrix[0][0] = k11;
+	constraint->normalMatrix[0][1] = k12;
+	constraint->normalMatrix[1][0] = k12;
+	constraint->normalMatrix[1][1] = k22;
+	float inverseDeterminant = 1.0f / determinant;
+	constraint->blockNormalMass[0][0] = k22 * inverseDeterminant;
+	constraint->blockNormalMass[0][1] = -k12 * inverseDeterminant;
+	constraint->blockNormalMass[1][0] = -k12 * inverseDeterminant;
+	constraint->blockNormalMass[1][1] = k11 * inverseDeterminant;
+}
+
+// how deep one contact point currently is, from where its anchors on the two bodies are now
+float getAnchoredDepth(bodyPool *pool, collisionResult *result, int index) {
+	int body1 = result->body1;
+	int body2 = result->body2;
+	Vector2 anchor1 = vec2Add(pool->position[body1], rotateByOrientation(result->localAnchor1[index], pool->orientation[body1]));
+	Vector2 anchor2 = vec2Add(pool->position[body2], rotateByOrientation(result->localAnchor2[index], pool->orientation[body2]));
+	return result->anchoredDepth[index] - vec2Dot(vec2Sub(anchor1, anchor2), result->normal);
+}
+
+// builds a constraint for every collision and picks up the impulses of matching
+// contact points from the last step. `contacts` must have been anchored, and `deltaTime` is the
+// length of the substep in frames
+void prepareContacts(contactSolver *solver, bodyPool *pool, contactList *contacts, float deltaTime) {
+	solver->count = 0;
+	solver->constraints = growArray(solver->constraints, &solver->capacity, contacts->count, sizeof(contactConstraint));
+	solver->pseudoVelocity = growArray(solver->pseudoVelocity, &solver->pseudoVelocityCapacity, pool->count, sizeof(Vector2));
+	solver->pseudoAngularVelocity = growArray(solver->pseudoAngularVelocity, &solver->pseudoAngularVelocityCapacity, pool->count, sizeof(float));
+	memset(solver->pseudoVelocity, 0, pool->count * sizeof(Vector2));
+	memset(solver->pseudoAngularVelocity, 0, pool->count * sizeof(float));
+
+	for (int i = 0; i < contacts->count; i++) {
+		collisionResult *result = &contacts->results[i];
+		contactConstraint *constraint = &solver->constraints[solver->count++];
+		int body1 = result->body1;
+		int body2 = result->body2;
+		physicsObject *object1 = &pool->objects[body1];
+		physicsObject *object2 = &pool->objects[body2];
+
+		constraint->body1 = body1;
+		constraint->body2 = body2;
+		constraint->normal = result->normal;
+		constraint->tangent = vec2Perp(result->normal);
+		constraint->staticFriction = (object1->staticFriction + object2->staticFriction) * 0.5f;
+		constraint->dynamicFriction = (object1->dynamicFriction + object2->dynamicFriction) * 0.5f;
+		constraint->numContacts = result->numContacts;
+		constraint->pairKey = result->pairKey;
+
+		contactManifold *manifold = findContactManifold(solver, result->pairKey);
+		Vector2 contactArray[2] = {result->contact1, result->contact2};
+		contactFeature featureArray[2] = {result->feature1, result->feature2};
+
+		for (int j = 0; j < constraint->numContacts; j++) {
+			solverContactPoint *point = &constraint->points[j];
+			point->r1 = vec2Sub(contactArray[j], pool->position[body1]);
+			point->r2 = vec2Sub(contactArray[j], pool->position[body2]);
+			point->normalMass = getEffectiveMass(pool, body1, body2, point->r1, point->r2, constraint->normal);
+			point->tangentMass = getEffectiveMass(pool, body1, body2, point->r1, point->r2, constraint->tangent);
+			point->feature = featureArray[j];
+			point->normalImpulse = 0.0f;
+			point->tangentImpulse = 0.0f;
+			point->pseudoImpulse = 0.0f;
+
+			float depth = getAnchoredDepth(pool, result, j);
+			float correction = POSITION_CORRECTION_FACTOR * fmaxf(depth - POSITION_SLOP, 0.0f) / deltaTime;
+			point->positionBias = fminf(correction, MAX_CORRECTION_VELOCITY);
+
+			float velocityProjection = vec2Dot(getContactRelativeVelocity(pool, constraint, point), constraint->normal);
+			point->velocityBias = 0.0f;
+			if (velocityProjection < -RESTITUTION_VELOCITY_THRESHOLD) {
+				point->velocityBias = -CONTACT_ELASTICITY * velocityProjection;
+			}
+
+			if (manifold == NULL) {
+				continue;
+			}
+			for (int k = 0; k < manifold->numContacts; k++) {
+				if (manifold->impulses[k].feature == point->feature) {
+					point->normalImpulse = manifold->impulses[k].normalImpulse;
+					point->tangentImpulse = manifold->impulses[k].tangentImpulse;
+					break;
+				}
+			}
+		}
+		prepareBlockSolve(pool, constraint);
+	}
+}
+
+// the warm start and solve passes below work on constraints [begin, end), which lets
+// independent islands be solved at the same time
+void warmStartContacts(contactSolver *solver, bodyPool *pool, int begin, int end) {
+	for (int i = begin; i < end; i++) {
+		contactConstraint *constraint = &solver->constraints[i];
+		for (int j = 0; j < constraint->numContacts; j++) {
+			solverContactPoint *point = &constraint->points[j];
+			Vector2 impulse = vec2Add(
+				vec2Scale(constraint->normal, point->normalImpulse),
+				vec2Scale(constraint->tangent, point->tangentImpulse)
+			);
+			applyContactImpulse(pool, constraint, point, impulse);
+		}
+	}
+}
+
+// finds the accumulated normal impulses of a two point contact that keep both positive and leave
+// neither point approaching. `b1` and `b2` are how fast each point would approach past its
+// target with no normal impulse at all. tries each combination of points being pushed on until
+// one fits, the same as a 2x2 LCP solver. returns false if none do, and the impulses stay as they are
+bool solveBlockImpulses(contactConstraint *constraint, float b1, float b2, float *impulse1, float *impulse2) {
+	float (*k)[2] = constraint->normalMatrix;
+	float (*inverse)[2] = constraint->blockNormalMass;
+
+	// both points pushing
+	float new1 = -(inverse[0][0] * b1 + inverse[0][1] * b2);
+	float new2 = -(inverse[1][0] * b1 + inverse[1][1] * b2);
+	if (new1 < 0.0f || new2 < 0.0f) {
+		// only the first
+		new1 = -b1 / k[0][0];
+		new2 = 0.0f;
+		if (new1 < 0.0f || k[1][0] * new1 + b2 < 0.0f) {
+			// only the second
+			new1 = 0.0f;
+			new2 = -b2 / k[1][1];
+			if (new2 < 0.0f || k[0][1] * new2 + b1 < 0.0f) {
+				// neither, then both points have to be separating already
+				new1 = 0.0f;
+				new2 = 0.0f;
+				if (b1 < 0.0f || b2 < 0.0f) {
+					return false;
+				}
+			}
+		}
+	}
+	*impulse1 = new1;
+	*impulse2 = new2;
+	return true;
+}
+
+// one sequential impulse pass over the contacts
+void solveContactVelocities(contactSolver *solver, bodyPool *pool, int begin, int end) {
+	for (int i = begin; i < end; i++) {
+		contactConstraint *constraint = &solver->constraints[i];
+
+		// friction first, it is less important than not sinking
+		for (int j = 0; j < constraint->numContacts; j++) {
+			solverContactPoint *point = &constraint->points[j];
+			float tangentVelocity = vec2Dot(getContactRelativeVelocity(pool, constraint, point), constraint->tangent);
+			float oldImpulse = point->tangentImpulse;
+			float newImpulse = oldImpulse - tangentVelocity * point->tangentMass;
+
+			// stick while under the static limit, slide with dynamic friction past it
+			float maxStatic = constraint->staticFriction * point->normalImpulse;
+			if (fabsf(newImpulse) > maxStatic) {
+				float maxDynamic = constraint->dynamicFriction * point->normalImpulse;
+				newImpulse = newImpulse > 0.0f ? maxDynamic : -maxDynamic;
+			}
+			point->tangentImpulse = newImpulse;
+			applyContactImpulse(pool, constraint, point, vec2Scale(constraint->tangent, newImpulse - oldImpulse));
+		}
+
+		if (constraint->blockSolve) {
+			solverContactPoint *point1 = &constraint->points[0];
+			solverContactPoint *point2 = &constraint->points[1];
+			float old1 = point1->normalImpulse;
+			float old2 = point2->normalImpulse;
+			float (*k)[2] = constraint->normalMatrix;
+			float velocity1 = vec2Dot(getContactRelativeVelocity(pool, constraint, point1), constraint->normal);
+			float velocity2 = vec2Dot(getContactRelativeVelocity(pool, constraint, point2), constraint->normal);
+			float b1 = velocity1 - point1->velocityBias - (k[0][0] * old1 + k[0][1] * old2);
+			float b2 = velocity2 - point2->velocityBias - (k[1][0] * old1 + k[1][1] * old2);
+			if (solveBlockImpulses(constraint, b1, b2, &point1->normalImpulse, &point2->normalImpulse)) {
+				applyContactImpulse(pool, constraint, point1, vec2Scale(constraint->normal, point1->normalImpulse - old1));
+				applyContactImpulse(pool, constraint, point2, vec2Scale(constraint->normal, point2->normalImpulse - old2));
+			}
+			continue;
+		}
+		for (int j = 0; j < constraint->numContacts; j++) {
+			solverContactPoint *point = &constraint->points[j];
+			float velocityProjection = vec2Dot(getContactRelativeVelocity(pool, constraint, point), constraint->normal);
+			float oldImpulse = point->normalImpulse;
+			// contacts can only push, so the total impulse is never allowed below zero
+			float newImpulse = fmaxf(oldImpulse + (point->velocityBias - velocityProjection) * point->normalMass, 0.0f);
+			point->normalImpulse = newImpulse;
+			applyContactImpulse(pool, constraint, point, vec2Scale(constraint->normal, newImpulse - oldImpulse));
+		}
+	}
+}
+
+// how fast the contact point on body1 moves away from the one on body2 along the normal,
+// going by the pseudo velocities
+float getPseudoNormalVelocity(contactSolver *solver, contactConstraint *constraint, solverContactPoint *point) {
+	int body1 = constraint->body1;
+	int body2 = constraint->body2;
+	Vector2 relativeVelocity = vec2Sub(
+		vec2Add(solver->pseudoVelocity[body1], vec2Scale(vec2Perp(point->r1), solver->pseudoAngularVelocity[body1])),
+		vec2Add(solver->pseudoVelocity[body2], vec2Scale(vec2Perp(point->r2), solver->pseudoAngularVelocity[body2]))
+	);
+	return vec2Dot(relativeVelocity, constraint->normal);
+}
+
+// applyContactImpulse for the pseudo velocities, `amount` is along the normal
+void applyPseudoImpulse(contactSolver *solver, bodyPool *pool, contactConstraint *constraint, solverContactPoint *point, float amount) {
+	int body1 = constraint->body1;
+	int body2 = constraint->body2;
+	Vector2 impulse = vec2Scale(constraint->normal, amount);
+	solver->pseudoVelocity[body1] = vec2Add(solver->pseudoVelocity[body1], vec2Scale(impulse, pool->invMass[body1]));
+	solver->pseudoAngularVelocity[body1] += vec2Cross(point->r1, impulse) * pool->invInertia[body1];
+	if (pool->invMass[body2] > 0.0f) {
+		solver->pseudoVelocity[body2] = vec2Sub(solver->pseudoVelocity[body2], vec2Scale(impulse, pool->invMass[body2]));
+		solver->pseudoAngularVelocity[body2] -= vec2Cross(point->r2, impulse) * pool->invInertia[body2];
+	}
+}
+
+// one pass of the split impulses, the same as the normal impulses but on the pseudo velocities
+void solveContactPositions(contactSolver *solver, bodyPool *pool, int begin, int end) {
+	for (int i = begin; i < end; i++) {
+		contactConstraint *constraint = &solver->constraints[i];
+		if (constraint->blockSolve) {
+			solverContactPoint *point1 = &constraint->points[0];
+			solverContactPoint *point2 = &constraint->points[1];
+			float old1 = point1->pseudoImpulse;
+			float old2 = point2->pseudoImpulse;
+			if (point1->positionBias == 0.0f && point2->positionBias == 0.0f && old1 == 0.0f && old2 == 0.0f) {
+				continue;
+			}
+			float (*k)[2] = constraint->normalMatrix;
+			float b1 = getPseudoNormalVelocity(solver, constraint, point1) - point1->positionBias - (k[0][0] * old1 + k[0][1] * old2);
+			float b2 = getPseudoNormalVelocity(solver, constraint, point2) - point2->positionBias - (k[1][0] * old1 + k[1][1] * old2);
+			if (solveBlockImpulses(constraint, b1, b2, &point1->pseudoImpulse, &point2->pseudoImpulse)) {
+				applyPseudoImpulse(solver, pool, constraint, point1, point1->pseudoImpulse - old1);
+				applyPseudoImpulse(solver, pool, constraint, point2, point2->pseudoImpulse - old2);
+			}
+			continue;
+		}
+		for (int j = 0; j < constraint->numContacts; j++) {
+			solverContactPoint *point = &constraint->points[j];
+			if (point->positionBias == 0.0f && point->pseudoImpulse == 0.0f) {
+				continue;
+			}
+			float oldImpulse = point->pseudoImpulse;
+			float newImpulse = fmaxf(oldImpulse + (point->positionBias - getPseudoNormalVelocity(solver, constraint, point)) * point->normalMass, 0.0f);
+			point->pseudoImpulse = newImpulse;
+			applyPseudoImpulse(solver, pool, constraint, point, newImpulse - oldImpulse);
+		}
+	}
+}
+
+// moves every body by its pseudo velocity over `deltaTime` frames. the transforms are only marked
+// dirty, they get rebuilt whenever something next needs them. constraints only ever push awake
+// bodies, so only the active ones can have a pseudo velocity
+void applyPseudoVelocities(contactSolver *solver, bodyPool *pool, float deltaTime) {
+	for (int a = 0; a < pool->activeCount; a++) {
+		int i = pool->activeBodies[a];
+		Vector2 pseudoVelocity = solver->pseudoVelocity[i];
+		float pseudoAngularVelocity = solver->pseudoAngularVelocity[i];
+		if (pseudoVelocity.x == 0.0f && pseudoVelocity.y == 0.0f && pseudoAngularVelocity == 0.0f) {
+			continue;
+		}
+		pool->position[i] = vec2Add(pool->position[i], vec2Scale(pseudoVelocity, deltaTime));
+		if (pseudoAngularVelocity != 0.0f) {
+			pool->rotation[i] += pseudoAngularVelocity * deltaTime;
+			pool->orientation[i] = (Vector2){cosf(pool->rotation[i]), sinf(pool->rotation[i])};
+		}
+		pool->transformDirty[i] = true;
+	}
+}
+
+// sorts constraints [begin, end) by colour, so that no two constraints of the same colour share
+// a dynamic body and every colour can be solved in parallel. static bodies never conflict,
+// they don't get written to. greedy, each constraint takes the first colour both its bodies
+// are still free in
+void colorConstraints(contactSolver *solver, bodyPool *pool, int begin, int end) {
+	int count = end - begin;
+	solver->bodyColors = growArray(solver->bodyColors, &solver->bodyColorCapacity, pool->count, sizeof(unsigned int));
+	solver->constraintColor = growArray(solver->constraintColor, &solver->constraintColorCapacity, count, sizeof(int));
+	solver->coloredConstraints = growArray(solver->coloredConstraints, &solver->coloredCapacity, count, sizeof(contactConstraint));
+	unsigned int *bodyColors = solver->bodyColors;
+	memset(bodyColors, 0, pool->count * sizeof(unsigned int));
+
+	int *colorStart = solver->colorStart;
+	memset(colorStart, 0, sizeof(solver->colorStart));
+	for (int i = 0; i < count; i++) {
+		contactConstraint *constraint = &solver->constraints[begin + i];
+		int body1 = constraint->body1;
+		int body2 = constraint->body2;
+		bool body2Dynamic = pool->invMass[body2] > 0.0f;
+		unsigned int used = bodyColors[body1] | (body2Dynamic ? bodyColors[body2] : 0);
+		unsigned int available = ~used & ((1u << GRAPH_COLOR_COUNT) - 1);
+
+		int color = GRAPH_OVERFLOW_COLOR;
+		if (available != 0) {
+			color = __builtin_ctz(available);
+			bodyColors[body1] |= 1u << color;
+			if (body2Dynamic) {
+				bodyColors[body2] |= 1u << color;
+			}
+		}
+		solver->constraintColor[i] = color;
+		colorStart[color + 1]++;
+	}
+
+	// counting sort, same as the islands
+	for (int c = 0; c <= GRAPH_OVERFLOW_COLOR; c++) {
+		colorStart[c + 1] += colorStart[c];
+	}
+	for (int i = 0; i < count; i++) {
+		solver->coloredConstraints[colorStart[solver->constraintColor[i]]++] = solver->constraints[begin + i];
+	}
+	for (int c = GRAPH_OVERFLOW_COLOR + 1; c > 0; c--) {
+		colorStart[c] = colorStart[c - 1] + begin;
+	}
+	colorStart[0] = begin;
+	memcpy(&solver->constraints[begin], solver->coloredConstraints, count * sizeof(contactConstraint));
+}
+
+int compareManifolds(const void *a, const void *b) {
+	unsigned long long key1 = ((const contactManifold *)a)->pairKey;
+	unsigned long long key2 = ((const contactManifold *)b)->pairKey;
+	return (key1 > key2) - (key1 < key2);
+}
+
+// remembers this step's impulses for warm starting the next one
+void storeContactImpulses(contactSolver *solver) {
+	solver->manifolds = growArray(solver->manifolds, &solver->manifoldCapacity, solver->count, sizeof(contactManifold));
+	solver->manifoldCount = solver->count;
+	for (int i = 0; i < solver->count; i++) {
+		contactConstraint *constraint = &solver->constraints[i];
+		contactManifold *manifold = &solver->manifolds[i];
+		manifold->pairKey = constraint->pairKey;
+		manifold->numContacts = constraint->numContacts;
+		for (int j = 0; j < constraint->numContacts; j++) {
+			manifold->impulses[j].feature = constraint->points[j].feature;
+			manifold->impulses[j].normalImpulse = constraint->points[j].normalImpulse;
+			manifold->impulses[j].tangentImpulse = constraint->points[j].tangentImpulse;
+		}
+	}
+	// nothing to sort, and with no contacts yet the array might still be NULL
+	if (solver->manifoldCount > 1) {
+		qsort(solver->manifolds, solver->manifoldCount, sizeof(contactManifold), compareManifolds);
+	}
+}
+
+// pins every contact point to both bodies, along with how deep that point was, call right
+// after collision detection
+void anchorContacts(bodyPool *pool, contactList *contacts) {
+	for (int i = 0; i < contacts->count; i++) {
+		collisionResult *result = &contacts->results[i];
+		int body1 = result->body1;
+		int body2 = result->body2;
+		Vector2 contactArray[2] = {result->contact1, result->contact2};
+		float depthArray[2] = {result->depth1, result->depth2};
+		for (int j = 0; j < result->numContacts; j++) {
+			result->localAnchor1[j] = unrotateByOrientation(vec2Sub(contactArray[j], pool->position[body1]), pool->orientation[body1]);
+			result->localAnchor2[j] = unrotateByOrientation(vec2Sub(contactArray[j], pool->position[body2]), pool->orientation[body2]);
+			result->anchoredDepth[j] = depthArray[j];
+		}
+	}
+}
+
+// moves the contacts along with their bodies instead of detecting them again.
+// the normal is kept, and a point's depth changes by however far its two anchors have drifted
+// apart along it. points that have come apart are dropped, and so are pairs that went to sleep
+void followContactAnchors(bodyPool *pool, contactList *contacts) {
+	int kept = 0;
+	for (int i = 0; i < contacts->count; i++) {
+		collisionResult *result = &contacts->results[i];
+		int body1 = result->body1;
+		int body2 = result->body2;
+		if (!pool->awake[body1] && !pool->awake[body2]) {
+			continue;
+		}
+
+		Vector2 contactArray[2];
+		contactFeature featureArray[2] = {result->feature1, result->feature2};
+		float depthArray[2];
+		int numContacts = 0;
+		float depth = 0.0f;
+		for (int j = 0; j < result->numContacts; j++) {
+			Vector2 anchor1 = vec2Add(pool->position[body1], rotateByOrientation(result->localAnchor1[j], pool->orientation[body1]));
+			Vector2 anchor2 = vec2Add(pool->position[body2], rotateByOrientation(result->localAnchor2[j], pool->orientation[body2]));
+			float pointDepth = result->anchoredDepth[j] - vec2Dot(vec2Sub(anchor1, anchor2), result->normal);
+			if (pointDepth < 0.0f) {
+				continue;
+			}
+			// keep the anchors lined up with the surviving points
+			result->localAnchor1[numContacts] = result->localAnchor1[j];
+			result->localAnchor2[numContacts] = result->localAnchor2[j];
+			result->anchoredDepth[numContacts] = result->anchoredDepth[j];
+			featureArray[numContacts] = featureArray[j];
+			depthArray[numContacts] = pointDepth;
+			contactArray[numContacts++] = vec2Scale(vec2Add(anchor1, anchor2), 0.5f);
+			depth = fmaxf(depth, pointDepth);
+		}
+		if (numContacts == 0) {
+			continue;
+		}
+
+		result->numContacts = numContacts;
+		result->contact1 = contactArray[0];
+		result->contact2 = contactArray[numContacts - 1];
+		result->feature1 = featureArray[0];
+		result->feature2 = featureArray[numContacts - 1];
+		result->depth1 = depthArray[0];
+		result->depth2 = depthArray[numContacts - 1];
+		result->penetrationDepth = depth;
+		contacts->results[kept++] = *result;
+	}
+	contacts->count = kept;
+}
+
+void freeContactSolver(contactSolver *solver) {
+	free(solver->constraints);
+	free(solver->manifolds);
+	free(solver->bodyColors);
+	free(solver->constraintColor);
+	free(solver->coloredConstraints);
+	free(solver->pseudoVelocity);
+	free(solver->pseudoAngularVelocity);
+	*solver = (contactSolver){0};
+}
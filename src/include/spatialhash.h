@@ -0,0 +1,174 @@
+// cell size of the finest grid level, in pixels
+#define HGRID_MIN_CELL_SIZE 32.0f
+// every level's cells are twice as big as the level below
+#define HGRID_MAX_LEVELS 16
+
+// one cell an object was inserted into
+typedef struct {
+	int cellX;
+	int cellY;
+	int level;
+	int objectIndex;
+} gridEntry;
+
+// multi-level uniform grid broadphase.
+// each object only goes into the level whose cells are at least as big as it is, so it touches
+// at most 2x2 cells no matter how big it is. cells are hashed into buckets, and all of the arrays
+// are flat and reused from step to step
+typedef struct {
+	gridEntry *entries;
+	int entryCount;
+	int entryCapacity;
+
+	// entries sorted by bucket, bucket b owns sortedEntries[bucketStart[b]] up to bucketStart[b + 1]
+	gridEntry *sortedEntries;
+	int sortedCapacity;
+	int *bucketStart;
+	int bucketCapacity;
+	int bucketCount;
+
+	int *objectLevel;
+	int levelCapacity;
+	unsigned int occupiedLevels;
+} hierarchicalGrid;
+
+float getGridCellSize(int level) {
+	return ldexpf(HGRID_MIN_CELL_SIZE, level);
+}
+
+int getGridLevel(AABB *box) {
+	float extent = fmaxf(box->max.x - box->min.x, box->max.y - box->min.y);
+	int level = 0;
+	while (level < HGRID_MAX_LEVELS - 1 && getGridCellSize(level) < extent) {
+		level++;
+	}
+	return level;
+}
+
+unsigned int hashGridCell(int cellX, int cellY, int level) {
+	return ((unsigned int)cellX * 73856093u) ^ ((unsigned int)cellY * 19349663u) ^ ((unsigned int)level * 83492791u);
+}
+
+int getGridCell(float value, float inverseCellSize) {
+	return (int)floorf(value * inverseCellSize);
+}
+
+// rebuilds the grid from the current boxes and writes every overlapping pair that has
+// at least one awake body into `pairs`. the grid keeps nothing between updates, so sleeping
+// bodies get bucketed again every time. for worlds that are mostly asleep use the tree, it only
+// looks at the active bodies
+void updateHierarchicalGrid(hierarchicalGrid *grid, bodyPool *pool, pairList *pairs) {
+	int objectCount = pool->count;
+	pairs->count = 0;
+	grid->entryCount = 0;
+	grid->occupiedLevels = 0;
+	grid->objectLevel = growArray(grid->objectLevel, &grid->levelCapacity, objectCount, sizeof(int));
+
+	// insert each object into the cells it covers on its own level
+	for (int i = 0; i < objectCount; i++) {
+		AABB *box = &pool->box[i];
+		int level = getGridLevel(box);
+		float inverseCellSize = 1.0f / getGridCellSize(level);
+		grid->objectLevel[i] = level;
+		grid->occupiedLevels |= 1u << level;
+
+		int minX = getGridCell(box->min.x, inverseCellSize);
+		int minY = getGridCell(box->min.y, inverseCellSize);
+		int maxX = getGridCell(box->max.x, inverseCellSize);
+		int maxY = getGridCell(box->max.y, inverseCellSize);
+		grid->entries = growArray(grid->entries, &grid->entryCapacity, grid->entryCount + (maxX - minX + 1) * (maxY - minY + 1), sizeof(gridEntry));
+		for (int y = minY; y <= maxY; y++) {
+			for (int x = minX; x <= maxX; x++) {
+				grid->entries[grid->entryCount++] = (gridEntry){x, y, level, i};
+			}
+		}
+	}
+
+	// bucket the entries with a counting sort, using twice as many buckets as entries
+	int bucketCount = 16;
+	while (bucketCount < grid->entryCount * 2) {
+		bucketCount *= 2;
+	}
+	grid->bucketCount = bucketCount;
+	grid->bucketStart = growArray(grid->bucketStart, &grid->bucketCapacity, bucketCount + 1, sizeof(int));
+	grid->sortedEntries = growArray(grid->sortedEntries, &grid->sortedCapacity, grid->entryCount, sizeof(gridEntry));
+	int *bucketStart = grid->bucketStart;
+	unsigned int bucketMask = (unsigned int)bucketCount - 1;
+
+	for (int i = 0; i <= bucketCount; i++) {
+		bucketStart[i] = 0;
+	}
+	for (int i = 0; i < grid->entryCount; i++) {
+		gridEntry *entry = &grid->entries[i];
+		bucketStart[(hashGridCell(entry->cellX, entry->cellY, entry->level) & bucketMask) + 1]++;
+	}
+	for (int i = 0; i < bucketCount; i++) {
+		bucketStart[i + 1] += bucketStart[i];
+	}
+	for (int i = 0; i < grid->entryCount; i++) {
+		gridEntry *entry = &grid->entries[i];
+		grid->sortedEntries[bucketStart[hashGridCell(entry->cellX, entry->cellY, entry->level) & bucketMask]++] = *entry;
+	}
+	// the scatter moved every start forward by one bucket, shift them back
+	for (int i = bucketCount; i > 0; i--) {
+		bucketStart[i] = bucketStart[i - 1];
+	}
+	bucketStart[0] = 0;
+
+	// every object looks for neighbours on its own level and on the levels above it.
+	// smaller objects always do the looking, so each pair is only found from one side
+	for (int index1 = 0; index1 < objectCount; index1++) {
+		AABB *box1 = &pool->box[index1];
+		int level1 = grid->objectLevel[index1];
+
+		for (int level = level1; level < HGRID_MAX_LEVELS; level++) {
+			if (!(grid->occupiedLevels & (1u << level))) {
+				continue;
+			}
+			float inverseCellSize = 1.0f / getGridCellSize(level);
+			int minX = getGridCell(box1->min.x, inverseCellSize);
+			int minY = getGridCell(box1->min.y, inverseCellSize);
+			int maxX = getGridCell(box1->max.x, inverseCellSize);
+			int maxY = getGridCell(box1->max.y, inverseCellSize);
+
+			for (int y = minY; y <= maxY; y++) {
+				for (int x = minX; x <= maxX; x++) {
+					unsigned int bucket = hashGridCell(x, y, level) & bucketMask;
+					for (int e = bucketStart[bucket]; e < bucketStart[bucket + 1]; e++) {
+						gridEntry *entry = &grid->sortedEntries[e];
+						// other cells can hash into the same bucket
+						if (entry->cellX != x || entry->cellY != y || entry->level != level) {
+							continue;
+						}
+						int index2 = entry->objectIndex;
+						if (index2 == index1 || (level == level1 && index2 < index1)) {
+							continue;
+						}
+						if (!pool->awake[index1] && !pool->awake[index2]) {
+							continue;
+						}
+						AABB *box2 = &pool->box[index2];
+						if (!AABBIntersect(box1, box2)) {
+							continue;
+						}
+						// both objects can share several cells, only report the pair from the cell
+						// holding the corner of their overlap
+						if (getGridCell(fmaxf(box1->min.x, box2->min.x), inverseCellSize) != x ||
+								getGridCell(fmaxf(box1->min.y, box2->min.y), inverseCellSize) != y) {
+							continue;
+						}
+						addPair(pairs, index1, index2);
+					}
+				}
+			}
+		}
+	}
+}
+
+void freeHierarchicalGrid(hierarchicalGrid *grid) {
+	free(grid->entries);
+	free(grid->sortedEntries);
+	free(grid->bucketStart);
+	free(grid->objectLevel);
+	*grid = (hierarchicalGrid){0};
+}
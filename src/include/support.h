@@ -0,0 +1,112 @@
+// shapes with at most this many points just scan all of them, it's faster than being clever
+#define SUPPORT_SCAN_MAX_POINTS 8
+
+// the deterministic mode turns the support cache off. pairs sharing a shape on different
+// threads race for it, and where two points tie the winner decides which one gets returned
+bool useSupportCache = true;
+
+// sorts a direction into one of SUPPORT_CACHE_BUCKETS octants without any trig
+int getDirectionBucket(Vector2 direction) {
+	int bucket = (direction.x < 0.0f) << 2 | (direction.y < 0.0f) << 1 | (fabsf(direction.x) < fabsf(direction.y));
+	return bucket;
+}
+
+// the vertex two adjacent edges share
+int getSharedVertex(int edge1, int edge2, int numPoints) {
+	return (edge1 + 1) % numPoints == edge2 ? edge2 : edge1;
+}
+
+// walks around the polygon from `start` for as long as the next point is further along
+// `direction`. a convex polygon has no other peaks to get stuck on
+int hillClimbSupport(polygonCollisionShape *shape, Vector2 direction, int start) {
+	Vector2 *points = shape->globalPointArray;
+	int numPoints = shape->numPoints;
+	int index = start;
+	float best = vec2Dot(points[index], direction);
+
+	int step = 1;
+	float next = vec2Dot(points[(index + 1) % numPoints], direction);
+	if (next <= best) {
+		step = numPoints - 1;
+		next = vec2Dot(points[(index + step) % numPoints], direction);
+	}
+	while (next > best) {
+		best = next;
+		index = (index + step) % numPoints;
+		next = vec2Dot(points[(index + step) % numPoints], direction);
+	}
+	return index;
+}
+
+// finds the support point from scratch: the direction gets turned into the prototype's local
+// space and looked up between the two edge normals around it
+int findSupportByAngle(polygonCollisionShape *shape, Vector2 direction) {
+	const shapePrototype *prototype = shape->prototype;
+	int numPoints = shape->numPoints;
+	// the body's rotation is whatever turns a local normal into its world copy
+	Vector2 localNormal = prototype->edgeNormals[0];
+	Vector2 worldNormal = shape->globalEdgeNormals[0];
+	float cosine = vec2Dot(localNormal, worldNormal);
+	float sine = vec2Cross(localNormal, worldNormal);
+	Vector2 localDirection = (Vector2){
+		direction.x * cosine + direction.y * sine,
+		direction.y * cosine - direction.x * sine
+	};
+	float angle = atan2f(localDirection.y, localDirection.x);
+
+	// first normal at or past the direction, wrapping back around to the start
+	int low = 0;
+	int high = numPoints;
+	while (low < high) {
+		int middle = (low + high) / 2;
+		if (prototype->normalAngles[middle] < angle) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+	int after = low % numPoints;
+	int before = (low + numPoints - 1) % numPoints;
+	return getSharedVertex(prototype->normalAngleEdges[before], prototype->normalAngleEdges[after], numPoints);
+}
+
+// index of the point of the shape furthest along `direction`.
+// bigger shapes start from wherever the last query in a similar direction ended, which barely
+// moves between substeps, and only do the angle lookup when there's nothing to start from
+int getSupportIndex(polygonCollisionShape *shape, Vector2 direction) {
+	if (shape->numPoints <= SUPPORT_SCAN_MAX_POINTS) {
+		Vector2 *points = shape->globalPointArray;
+		int bestIndex = 0;
+		float bestDot = vec2Dot(points[0], direction);
+		for (int i = 1; i < shape->numPoints; i++) {
+			float dotProduct = vec2Dot(points[i], direction);
+			if (dotProduct > bestDot) {
+				bestDot = dotProduct;
+				bestIndex = i;
+			}
+		}
+		return bestIndex;
+	}
+
+	if (!useSupportCache) {
+		return hillClimbSupport(shape, direction, findSupportByAngle(shape, direction));
+	}
+	int bucket = getDirectionBucket(direction);
+	int start = atomic_load_explicit(&shape->supportCache[bucket], memory_order_relaxed);
+	if (start < 0) {
+		start = findSupportByAngle(shape, direction);
+	}
+	int index = hillClimbSupport(shape, direction, start);
+	atomic_store_explicit(&shape->supportCache[bucket], index, memory_order_relaxed);
+	return index;
+}
+
+Vector2 getSupportPoint(polygonCollisionShape *shape, Vector2 direction) {
+	return shape->globalPointArray[getSupportIndex(shape, direction)];
+}
+
+// how far the shape reaches either way along `axis`
+void projectShapeOntoAxis(polygonCollisionShape *shape, Vector2 axis, float *min, float *max) {
+	*max = vec2Dot(getSupportPoint(shape, axis), axis);
+	*min = vec2Dot(getSupportPoint(shape, vec2Negate(axis)), axis);
+}
@@ -1,47 +1,101 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <float.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
 #include "math.h"
 #include "include/raylib.h"
 #include "types.h"
 #include "include/vectormath.h"
 #include "include/objects.h"
+#include "include/satkernel.h"
+#include "include/support.h"
 #include "include/collision.h"
+#include "include/gjk.h"
+#include "include/colliders.h"
+#include "include/growarray.h"
+#include "include/jobs.h"
+#include "include/arena.h"
+#include "include/prototypes.h"
+#include "include/bodypool.h"
+#include "include/broadphase.h"
+#include "include/aabbtree.h"
+#include "include/spatialhash.h"
+#include "include/solver.h"
+#include "include/satcache.h"
+#include "include/islands.h"
 
 
-#define MAX_OBJECTS 20
 // amount of physics iterations per frame
 #define SUBSTEP_AMOUNT 20
 // factor to multiply position changes by
 #define SUBSTEP_FACTOR 0.05f
-
-#define POSITION_SLOP 0.01f
-
-int selectedObject = -1;
-
-physicsObject objectArray[MAX_OBJECTS];
-int objectCount = 0;
+// collision detection only runs every this many substeps. the ones in between move the contacts
+// it found along with their bodies and solve those again, which is much cheaper.
+// 1 detects every substep, SUBSTEP_AMOUNT once per frame
+#define CONTACT_DETECTION_INTERVAL 4
+// velocity passes the contact solver makes per substep. one is enough for short stacks, but a
+// tall pyramid then sags a little every layer and never gets slow enough to sleep
+#define SOLVER_ITERATIONS 2
+// how many bodies, pairs and islands a single job gets at least
+#define JOB_BODY_BATCH 256
+#define JOB_PAIR_BATCH 64
+#define JOB_ISLAND_BATCH 4
+#define JOB_CONSTRAINT_BATCH 32
+
+bodyHandle selectedBody = {NULL_BODY_SLOT, 0};
+
+bodyPool bodies = {.freeSlot = NULL_BODY_SLOT};
+shapeAllocator shapeMemory;
+shapePrototypeCache shapePrototypes;
 float gravity = 0.6f;
 
+// for lockstep multiplayer and replays, see setDeterministicMode
+bool deterministicMode = false;
+// hash of every body after the last substep, only kept up to date in deterministic mode
+unsigned long long worldHash;
+
+// pick this before creating any bodies, only the active broadphase tracks them
+broadphaseType activeBroadphase = BROADPHASE_SWEEP_AND_PRUNE;
+sweepAndPrune sweepBroadphase;
+pairList sweepPairs;
+aabbTree treeBroadphase = {.root = AABB_TREE_NULL, .freeList = AABB_TREE_NULL};
+hierarchicalGrid gridBroadphase;
+pairList gridPairs;
+contactList contacts;
+contactSolver solver;
+separatingAxisCache satCache;
+islandBuilder islands;
+jobSystem jobs;
+pairCollision *pairCollisions;
+int pairCollisionCapacity;
+
 // TODO: unclutter main.c :D
 
-void applyPolygonTransform(physicsObject *object) {
-	polygonCollisionShape *poly = object->collisionShape;
-	AABB *box = &object->box;
+void applyPolygonTransform(int index) {
+	polygonCollisionShape *poly = bodies.objects[index].collisionShape;
+	Vector2 position = bodies.position[index];
+	float cosine = bodies.orientation[index].x;
+	float sine = bodies.orientation[index].y;
 
 	Vector2 min = (Vector2){INFINITY, INFINITY};
 	Vector2 max = (Vector2){-INFINITY, -INFINITY};
 
 	for (int i = 0; i < poly->numPoints; i++) {
 		// Apply rotation (radians)
-		float rotatedX = poly->pointArray[i].x * cosf(object->rotation) -
-										poly->pointArray[i].y * sinf(object->rotation);
-		float rotatedY = poly->pointArray[i].x * sinf(object->rotation) +
-										poly->pointArray[i].y * cosf(object->rotation);
+		float rotatedX = poly->pointArray[i].x * cosine -
+										poly->pointArray[i].y * sine;
+		float rotatedY = poly->pointArray[i].x * sine +
+										poly->pointArray[i].y * cosine;
 
 		// Apply translation
 		poly->globalPointArray[i] = vec2Add(
-																	object->position,
+																	position,
 																	(Vector2){rotatedX, rotatedY}
 															);
 		// set AABB
@@ -58,211 +112,339 @@ void applyPolygonTransform(physicsObject *object) {
 			max.y = poly->globalPointArray[i].y;
 		}
 	}
-	box->min = min;
-	box->max = max;
-	DrawRectangleLines(min.x - 2, min.y - 2, max.x - min.x + 4, max.y - min.y + 4, RED);
-}
-
-void separateBodies(physicsObject *object1, physicsObject *object2, Vector2 penetration) {
-	// we already know that object1 is no longer a static body
-	if (object2->isStaticBody) {
-		object1->position = vec2Add(object1->position, penetration);
-		applyPolygonTransform(object1);
+	// normals only need the rotation
+	const Vector2 *localNormals = poly->prototype->edgeNormals;
+	for (int i = 0; i < poly->numPoints; i++) {
+		poly->globalEdgeNormals[i] = (Vector2){
+			localNormals[i].x * cosine - localNormals[i].y * sine,
+			localNormals[i].x * sine + localNormals[i].y * cosine
+		};
 	}
-	else {
-		object1->position = vec2Add(object1->position, vec2Scale(penetration, 0.5f));
-		object2->position = vec2Add(object2->position, vec2Scale(penetration, -0.5f));
-		applyPolygonTransform(object1);
-		applyPolygonTransform(object2);
+	for (int i = 0; i < poly->numPoints; i++) {
+		poly->globalX[i] = poly->globalPointArray[i].x;
+		poly->globalY[i] = poly->globalPointArray[i].y;
 	}
-
+	for (int i = poly->numPoints; i < poly->paddedNumPoints; i++) {
+		poly->globalX[i] = poly->globalX[0];
+		poly->globalY[i] = poly->globalY[0];
+	}
+	// circles and capsules stick out past their points
+	bodies.box[index].min = vec2Sub(min, (Vector2){poly->radius, poly->radius});
+	bodies.box[index].max = vec2Add(max, (Vector2){poly->radius, poly->radius});
+	bodies.transformDirty[index] = false;
 }
 
-void resolveVelocity(collisionResult *result) {
-	physicsObject *object1 = result->object1;
-	physicsObject *object2 = result->object2;
-
-	// cache velocities before collision
-	Vector2 velocity1 = object1->velocity;
-	Vector2 velocity2 = object2->velocity;
-	float angularVelocity1 = object1->angularVelocity;
-	float angularVelocity2 = object2->angularVelocity;
-
-	Vector2 normal = result->normal;
-
-	float elasticity = 0.5f; // TODO: put this inside of the physicsObject
-
-	int numContacts  = result->numContacts;
-	Vector2 contactArray[2] = {result->contact1, result->contact2};
-	float impulseArray[2] = {0.0f, 0.0f};
-
-	float staticFriction = (object1->staticFriction + object2->staticFriction) * 0.5f;
-	float dynamicFriction = (object1->dynamicFriction + object2->dynamicFriction) * 0.5f;
-
-	for (int i = 0; i < numContacts; i++) {
-		Vector2 r1 = vec2Sub(contactArray[i], object1->position);
-		Vector2 r2 = vec2Sub(contactArray[i], object2->position);
-
-		Vector2 r1Perp = vec2Perp(r1);
-		Vector2 r2Perp = vec2Perp(r2);
-
-		Vector2 angularLinearVelocity1 = vec2Scale(r1Perp, angularVelocity1);
-		Vector2 angularLinearVelocity2 = vec2Scale(r2Perp, angularVelocity2);
-
-		Vector2 relativeVelocity = vec2Sub(
-				vec2Add(velocity1, angularLinearVelocity1),
-				vec2Add(velocity2, angularLinearVelocity2)
-		);
+// world space points and the AABB are only rebuilt when something reads them, so a body that
+// gets moved several times in a substep only pays for one transform
+void markTransformDirty(int index) {
+	bodies.transformDirty[index] = true;
+	// so updateBounds and the broadphase notice, even if it isn't awake
+	activateBody(&bodies, index);
+}
 
-		float velocityProjection = vec2Dot(relativeVelocity, normal);
+void ensureBodyTransform(int index) {
+	if (bodies.transformDirty[index]) {
+		applyPolygonTransform(index);
+	}
+}
 
-		if (velocityProjection > 0.0f) {
-			continue;
+// integrates active bodies [begin, end). static bodies never pick up any velocity (their invMass
+// is zero) and ones that just fell asleep had theirs zeroed, so only gravity has to check
+void integrateBodyRange(int begin, int end, void *context) {
+	int *activeBodies = bodies.activeBodies;
+	for (int a = begin; a < end; a++) {
+		int i = activeBodies[a];
+		// apply the position and multiply the velocity by the factor to keep it scaled properly
+		bodies.position[i].x += bodies.velocity[i].x * SUBSTEP_FACTOR;
+		bodies.position[i].y += bodies.velocity[i].y * SUBSTEP_FACTOR;
+		if (bodies.invMass[i] > 0.0f && bodies.awake[i]) {
+			bodies.velocity[i].y += gravity * SUBSTEP_FACTOR;
+		}
+		// only pay for the trig on bodies that actually turned
+		if (bodies.angularVelocity[i] != 0.0f) {
+			bodies.rotation[i] += bodies.angularVelocity[i] * SUBSTEP_FACTOR;
+			bodies.orientation[i] = (Vector2){cosf(bodies.rotation[i]), sinf(bodies.rotation[i])};
+		}
+		if (bodies.velocity[i].x != 0.0f || bodies.velocity[i].y != 0.0f || bodies.angularVelocity[i] != 0.0f) {
+			bodies.transformDirty[i] = true;
 		}
-		float r1PerpDotNormal = vec2Dot(r1Perp, normal);
-		float r2PerpDotNormal = vec2Dot(r2Perp, normal);
-		float impulse =
-		(-(1.0f + elasticity) * velocityProjection) /
-		(
-				(object1->invMass + object2->invMass) +
-				((r2PerpDotNormal * r2PerpDotNormal) * object2->invInertia) +
-				((r1PerpDotNormal * r1PerpDotNormal) * object1->invInertia)
-		);
-		impulse /= (float)numContacts;
-		impulseArray[i] = impulse;
-		// applying velocity
-		Vector2 impulseVector = vec2Scale(normal, impulse);
-		object1->velocity = vec2Add(object1->velocity, vec2Scale(impulseVector, object1->invMass));
-		object1->angularVelocity += vec2Cross(r1, impulseVector) * object1->invInertia;
-		object2->velocity = vec2Sub(object2->velocity, vec2Scale(impulseVector, object2->invMass));
-		object2->angularVelocity -= vec2Cross(r2, impulseVector) * object2->invInertia;
 	}
+}
 
-	velocity1 = object1->velocity;
-	velocity2 = object2->velocity;
-	angularVelocity1 = object1->angularVelocity;
-	angularVelocity2 = object2->angularVelocity;
-	for (int i = 0; i < numContacts; i++) {
-
-		Vector2 r1 = vec2Sub(contactArray[i], object1->position);
-		Vector2 r2 = vec2Sub(contactArray[i], object2->position);
+// sleeping and static bodies aren't on the active list, so a settled world integrates nothing
+void integrateBodies() {
+	parallelFor(&jobs, bodies.activeCount, JOB_BODY_BATCH, integrateBodyRange, NULL);
+}
 
-		Vector2 r1Perp = vec2Perp(r1);
-		Vector2 r2Perp = vec2Perp(r1);
+void updateBoundsRange(int begin, int end, void *context) {
+	for (int a = begin; a < end; a++) {
+		ensureBodyTransform(bodies.activeBodies[a]);
+	}
+}
 
-		Vector2 angularLinearVelocity1 = vec2Scale(r1Perp, angularVelocity1);
-		Vector2 angularLinearVelocity2 = vec2Scale(r2Perp, angularVelocity2);
+// the broadphase needs every box, so this is where most transforms end up being rebuilt.
+// nothing off the active list can be dirty: sleeping bodies were rebuilt here one last time
+// before pruneActiveBodies let them go, and moving one by hand puts it back on
+void updateBounds() {
+	parallelFor(&jobs, bodies.activeCount, JOB_BODY_BATCH, updateBoundsRange, NULL);
+}
 
-		Vector2 relativeVelocity = vec2Sub(vec2Add(velocity1, angularLinearVelocity1),
-																			vec2Add(velocity2, angularLinearVelocity2));
+// runs the colliders on pairs [begin, end) of `context`, a pairList. only reads the cache and
+// the bodies, everything that has to change is left for findContacts to do in order
+void collidePairRange(int begin, int end, void *context) {
+	pairList *pairs = context;
+	for (int i = begin; i < end; i++) {
+		pairCollision *collision = &pairCollisions[i];
+		collision->tested = false;
+		int index1 = pairs->pairs[i].index1;
+		int index2 = pairs->pairs[i].index2;
+		// sleeping and static bodies can't have moved into each other
+		if (!bodies.awake[index1] && !bodies.awake[index2]) {
+			continue;
+		}
+		// the broadphase may hand out fattened or stale boxes
+		if (!(AABBIntersect(&bodies.box[index1], &bodies.box[index2]))) {
+			continue;
+		}
+		// keep body1 the dynamic one of the pair, or the one in the lower slot if both are. then the
+		// pair comes out the same way round every step, however the pool gets shuffled, and its
+		// normal and contact features still match the ones warm starting kept
+		if (bodies.objects[index1].isStaticBody ||
+				(!bodies.objects[index2].isStaticBody && bodies.denseToSlot[index1] > bodies.denseToSlot[index2])) {
+			int temp = index1;
+			index1 = index2;
+			index2 = temp;
+		}
 
-		Vector2 tangent = vec2Sub(relativeVelocity, vec2Scale(normal, vec2Dot(relativeVelocity, normal)));
+		polygonCollisionShape *shape1 = bodies.objects[index1].collisionShape;
+		polygonCollisionShape *shape2 = bodies.objects[index2].collisionShape;
+		// an axis of -1 never gets stored
+		collision->axis = (separatingAxis){-1, 0};
+		bool useCache = shapesUseSeparatingAxis(shape1, shape2);
+		if (useCache) {
+			collision->axis = getCachedSeparatingAxis(&satCache, getBodyId(&bodies, index1), getBodyId(&bodies, index2));
+		}
+		collision->result = collideShapes(shape1, shape2, useCache ? &collision->axis : NULL);
+		collision->result.body1 = index1;
+		collision->result.body2 = index2;
+		collision->tested = true;
+	}
+}
 
-		// if the vector is nearly zero, stop this iteration
-		if (vec2IsZeroApprox(tangent)) {
+// runs the narrowphase on every broadphase pair in parallel, then collects the ones that
+// actually touch
+void findContacts(pairList *pairs) {
+	contacts.count = 0;
+	beginSeparatingAxisStep(&satCache);
+	pairCollisions = growArray(pairCollisions, &pairCollisionCapacity, pairs->count, sizeof(pairCollision));
+	parallelFor(&jobs, pairs->count, JOB_PAIR_BATCH, collidePairRange, pairs);
+
+	// the cache can rehash and waking touches whole islands, so this part stays serial
+	for (int i = 0; i < pairs->count; i++) {
+		pairCollision *collision = &pairCollisions[i];
+		if (!collision->tested) {
 			continue;
-		} else {
-			tangent = vec2Normalize(tangent);
 		}
+		collisionResult *result = &collision->result;
+		unsigned int id1 = getBodyId(&bodies, result->body1);
+		unsigned int id2 = getBodyId(&bodies, result->body2);
+		storeSeparatingAxis(&satCache, id1, id2, collision->axis);
+		if (result->isCollided) {
+			// whatever an awake body runs into has to be awake for the solver to push back
+			wakeBody(&bodies, result->body1);
+			wakeBody(&bodies, result->body2);
+			// keyed by id so the manifold survives bodies moving around in the pool, but not
+			// a new body taking over one of their slots
+			result->pairKey = makePairKey(id1, id2);
+			contacts.results = growArray(contacts.results, &contacts.capacity, contacts.count + 1, sizeof(collisionResult));
+			contacts.results[contacts.count++] = *result;
+		}
+	}
+}
 
-		float r1PerpDotTangent = vec2Dot(r1Perp, tangent);
-		float r2PerpDotTangent = vec2Dot(r2Perp, tangent);
+// solves islands [begin, end), each one from start to finish
+void solveIslandRange(int begin, int end, void *context) {
+	for (int island = begin; island < end; island++) {
+		int first = islands.islandStart[island];
+		int last = islands.islandStart[island + 1];
+		warmStartContacts(&solver, &bodies, first, last);
+		for (int i = 0; i < SOLVER_ITERATIONS; i++) {
+			solveContactVelocities(&solver, &bodies, first, last);
+			solveContactPositions(&solver, &bodies, first, last);
+		}
+	}
+}
 
-		float frictionImpulse = -vec2Dot(relativeVelocity, tangent) /
-									((
-										(object1->invMass + object2->invMass) +
-										((r1PerpDotTangent * r1PerpDotTangent) * object1->invInertia) +
-										((r2PerpDotTangent * r2PerpDotTangent) * object2->invInertia)
-									) * (float)numContacts);
+// the colour passes get the first constraint of their colour as `context`
+void warmStartColorRange(int begin, int end, void *context) {
+	int first = *(int *)context;
+	warmStartContacts(&solver, &bodies, first + begin, first + end);
+}
 
-		Vector2 frictionImpulseVector;
+// the velocity and position passes never read each other's velocities, so one job can do both
+void solveColorRange(int begin, int end, void *context) {
+	int first = *(int *)context;
+	solveContactVelocities(&solver, &bodies, first + begin, first + end);
+	solveContactPositions(&solver, &bodies, first + begin, first + end);
+}
 
-		if (fabsf(frictionImpulse) <= impulseArray[i] * staticFriction) {
-			frictionImpulseVector = vec2Scale(tangent, frictionImpulse);
+// every colour is one parallel for, apart from the overflow one
+void solveColoredConstraints() {
+	int *colorStart = solver.colorStart;
+	for (int c = 0; c <= GRAPH_OVERFLOW_COLOR; c++) {
+		int count = colorStart[c + 1] - colorStart[c];
+		if (c == GRAPH_OVERFLOW_COLOR) {
+			warmStartColorRange(0, count, &colorStart[c]);
 		} else {
-			frictionImpulseVector = vec2Scale(tangent, -impulseArray[i] * dynamicFriction);
+			parallelFor(&jobs, count, JOB_CONSTRAINT_BATCH, warmStartColorRange, &colorStart[c]);
 		}
-		object1->velocity = vec2Add(object1->velocity, vec2Scale(frictionImpulseVector, object1->invMass));
-		object1->angularVelocity += vec2Cross(r1, frictionImpulseVector) * object1->invInertia;
-		object2->velocity = vec2Sub(object2->velocity, vec2Scale(frictionImpulseVector, object2->invMass));
-		object2->angularVelocity -= vec2Cross(r2, frictionImpulseVector) * object2->invInertia;
 	}
-}
-
-void handleCollision(physicsObject *object1) {
-	for (int i = 0; i < objectCount; i++) {
-		physicsObject *object2 = &objectArray[i];
-		if (object1 != object2) {
-			if (!(AABBIntersect(&object1->box, &object2->box))) {
-				continue;
-			}
-
-			collisionResult result = polygonIntersect(object1, object2);
-			if (result.isCollided) {
-				Vector2 penetration = vec2Scale(result.normal, result.penetrationDepth);
-				separateBodies(result.object1, result.object2, penetration);
-				resolveVelocity(&result);
+	for (int i = 0; i < SOLVER_ITERATIONS; i++) {
+		for (int c = 0; c <= GRAPH_OVERFLOW_COLOR; c++) {
+			int count = colorStart[c + 1] - colorStart[c];
+			if (c == GRAPH_OVERFLOW_COLOR) {
+				solveColorRange(0, count, &colorStart[c]);
+			} else {
+				parallelFor(&jobs, count, JOB_CONSTRAINT_BATCH, solveColorRange, &colorStart[c]);
 			}
 		}
 	}
 }
 
-
-void handleVelocity(physicsObject *object) {
-	// apply the position and multiply the velocity by the factor to keep it scaled properly
-	object->position = vec2Add(object->position, vec2Scale(object->velocity, SUBSTEP_FACTOR));
-	object->velocity.y += (gravity * SUBSTEP_FACTOR);
-	object->rotation += (object->angularVelocity * SUBSTEP_FACTOR);
-	handleCollision(object);
+void solveContacts() {
+	// constraints come out in contact order, so they end up grouped by island as well
+	groupContactsByIsland(&islands, &bodies, &contacts);
+	prepareContacts(&solver, &bodies, &contacts, SUBSTEP_FACTOR);
+	// small islands get a thread each
+	parallelFor(&jobs, islands.largeIslandStart, JOB_ISLAND_BATCH, solveIslandRange, NULL);
+	// one large pile would keep a single thread busy while the rest wait, so the large islands
+	// are graph coloured together and solved a colour at a time instead
+	int firstLarge = islands.islandStart[islands.largeIslandStart];
+	if (firstLarge < solver.count) {
+		colorConstraints(&solver, &bodies, firstLarge, solver.count);
+		solveColoredConstraints();
+	}
+	applyPseudoVelocities(&solver, &bodies, SUBSTEP_FACTOR);
+	storeContactImpulses(&solver);
 }
 
 void drawPhysicsPolygon(polygonCollisionShape *poly, Color color) {
-	DrawTriangleFan(poly->globalPointArray, poly->numPoints, color);
+	switch (poly->type) {
+		case SHAPE_CIRCLE:
+			DrawCircleV(poly->globalPointArray[0], poly->radius, color);
+			break;
+		case SHAPE_CAPSULE:
+			DrawLineEx(poly->globalPointArray[0], poly->globalPointArray[1], poly->radius * 2.0f, color);
+			DrawCircleV(poly->globalPointArray[0], poly->radius, color);
+			DrawCircleV(poly->globalPointArray[1], poly->radius, color);
+			break;
+		case SHAPE_POLYGON:
+		case SHAPE_BOX:
+		default:
+			DrawTriangleFan(poly->globalPointArray, poly->numPoints, color);
+			break;
+	}
 }
 
-void createPhysicsRect(Vector2 center, Vector2 dimensions, float rotation, bool isStaticBody, float mass, float gravityStrength) {
-	if (objectCount >= MAX_OBJECTS) {
-		return;
+void addBroadphaseObject(int index) {
+	switch (activeBroadphase) {
+		case BROADPHASE_AABB_TREE:
+			addAABBTreeObject(&treeBroadphase, &bodies, index);
+			break;
+		case BROADPHASE_HIERARCHICAL_GRID:
+			// rebuilt from scratch every step
+			break;
+		case BROADPHASE_SWEEP_AND_PRUNE:
+		default:
+			addSweepAndPruneObject(&sweepBroadphase, index);
+			break;
 	}
-	// Create a physics shape based on dimensions (using malloc to avoid a dangling pointer)
-	polygonCollisionShape *rectShape =  (polygonCollisionShape *)malloc(sizeof(polygonCollisionShape));
-	rectShape->numPoints = 4;
-	rectShape->pointArray = (Vector2 *)malloc(rectShape->numPoints * sizeof(Vector2));
-	rectShape->globalPointArray = (Vector2 *)malloc(rectShape->numPoints * sizeof(Vector2));
-	rectShape->pointArray[0] = (Vector2){dimensions.x * -0.5f, dimensions.y * -0.5f}; // top left
-	rectShape->pointArray[1] = (Vector2){dimensions.x * -0.5f, dimensions.y * 0.5f}; // bottom left
-	rectShape->pointArray[2] = (Vector2){dimensions.x * 0.5f, dimensions.y * 0.5f}; // bottom right
-	rectShape->pointArray[3] = (Vector2){dimensions.x * 0.5f, dimensions.y * -0.5f}; // top right
+}
+
+void removeBroadphaseObject(int index, int lastIndex) {
+	switch (activeBroadphase) {
+		case BROADPHASE_AABB_TREE:
+			removeAABBTreeObject(&treeBroadphase, index, lastIndex);
+			break;
+		case BROADPHASE_HIERARCHICAL_GRID:
+			break;
+		case BROADPHASE_SWEEP_AND_PRUNE:
+		default:
+			removeSweepAndPruneObject(&sweepBroadphase, index, lastIndex);
+			break;
+	}
+}
+
+bodyHandle createPhysicsBody(shapePrototype *prototype, Vector2 center, float rotation, bool isStaticBody, float mass, float gravityStrength) {
+	// the prototype is shared, the body only gets its own world space points
+	polygonCollisionShape *shape = allocatePolygonShape(&shapeMemory, prototype);
+	retainShapePrototype(prototype);
 
 	// create the physicsObject and assign collision shape
 	physicsObject object;
-	object.collisionShape = rectShape;
+	object.collisionShape = shape;
 
 	object.gravityStrength = gravityStrength;
 	object.staticFriction = 0.6f;
 	object.dynamicFriction = 0.3f;
-
-	object.position = center;
-	object.rotation = rotation;
-	object.velocity = (Vector2){0, 0};
-	object.angularVelocity = 0.0f;
 	object.isStaticBody = isStaticBody;
 
 	if (object.isStaticBody) {
 		object.inertia = 0.0f;
 		object.mass = 0.0f;
-		object.invMass = 0.0f;
-		object.invInertia = 0.0f;
 	} else {
-		object.inertia = getPolygonInertia(rectShape);
+		object.inertia = prototype->inertia;
 		object.mass = mass;
-		object.invMass = 1.0f / object.mass;
-		object.invInertia = 1.0f / object.inertia;
 	}
 
-	// apply transforms _before_ adding to the array
-	applyPolygonTransform(&object);
-	objectArray[objectCount++] = object;
+	bodyHandle handle = addBody(&bodies, object);
+	int index = bodies.count - 1;
+	bodies.position[index] = center;
+	setBodyRotation(&bodies, index, rotation);
+	if (!object.isStaticBody) {
+		bodies.invMass[index] = 1.0f / object.mass;
+		bodies.invInertia[index] = 1.0f / object.inertia;
+		setBodyAwake(&bodies, index, true);
+	}
+
+	// apply transforms _before_ handing it to the broadphase
+	ensureBodyTransform(index);
+	addBroadphaseObject(index);
+	return handle;
+}
+
+bodyHandle createPhysicsRect(Vector2 center, Vector2 dimensions, float rotation, bool isStaticBody, float mass, float gravityStrength) {
+	// every rectangle of the same size shares one prototype
+	return createPhysicsBody(getRectPrototype(&shapePrototypes, dimensions), center, rotation, isStaticBody, mass, gravityStrength);
+}
+
+bodyHandle createPhysicsCircle(Vector2 center, float radius, bool isStaticBody, float mass, float gravityStrength) {
+	return createPhysicsBody(getCirclePrototype(&shapePrototypes, radius), center, 0.0f, isStaticBody, mass, gravityStrength);
+}
+
+// `length` is the distance between the centers of the end caps, and it lies along the rotation
+bodyHandle createPhysicsCapsule(Vector2 center, float length, float radius, float rotation, bool isStaticBody, float mass, float gravityStrength) {
+	return createPhysicsBody(getCapsulePrototype(&shapePrototypes, length, radius), center, rotation, isStaticBody, mass, gravityStrength);
+}
+
+void destroyPhysicsObject(bodyHandle handle) {
+	int index = getBodyIndex(&bodies, handle);
+	if (index < 0) {
+		return;
+	}
+	// anything resting on it has to notice it's gone. a sleeping body's island holds everything
+	// that was touching it when it fell asleep, and an awake body woke whatever it touched
+	if (bodies.objects[index].isStaticBody) {
+		wakeIslandsRestingOn(&islands, &bodies, index);
+	} else {
+		wakeBody(&bodies, index);
+	}
+	// the last body is about to be moved into this one's place
+	removeBroadphaseObject(index, bodies.count - 1);
+	polygonCollisionShape *shape = bodies.objects[index].collisionShape;
+	releaseShapePrototype(&shapePrototypes, (shapePrototype *)shape->prototype);
+	releasePolygonShape(&shapeMemory, shape);
+	removeBody(&bodies, handle);
 }
 
 void initializeShapes() {
@@ -272,64 +454,125 @@ void initializeShapes() {
 	createPhysicsRect((Vector2){500, 10}, (Vector2){50, 50}, 0.0f, false, 1.0f, 1.0f);
 	createPhysicsRect((Vector2){500, 100}, (Vector2){50, 50}, 0.0f, false, 1.0f, 1.0f);
 	createPhysicsRect((Vector2){400, 10}, (Vector2){200, 200}, 0.4f, false, 1.0f, 1.0f);
+	createPhysicsCircle((Vector2){250, -100}, 25.0f, false, 1.0f, 1.0f);
+	createPhysicsCapsule((Vector2){100, -100}, 60.0f, 15.0f, 0.3f, false, 1.0f, 1.0f);
 	createPhysicsRect((Vector2){0, 500}, (Vector2){1920, 50}, 0.0f, true, 5.0f, 1.0f);
 }
 
-void physicsTick() {
-	for (int j = 0; j < objectCount; j++) {
-		physicsObject *object = &objectArray[j];
-		if (object->isStaticBody) {
-			continue;
+pairList *updateBroadphase() {
+	switch (activeBroadphase) {
+		case BROADPHASE_AABB_TREE:
+			return updateAABBTree(&treeBroadphase, &bodies);
+		case BROADPHASE_HIERARCHICAL_GRID:
+			updateHierarchicalGrid(&gridBroadphase, &bodies, &gridPairs);
+			return &gridPairs;
+		case BROADPHASE_SWEEP_AND_PRUNE:
+		default:
+			updateSweepAndPrune(&sweepBroadphase, &bodies);
+			findSweepAndPrunePairs(&sweepBroadphase, &bodies, &sweepPairs);
+			return &sweepPairs;
+	}
+}
+
+void physicsTick(bool detectContacts) {
+	// every phase runs over all bodies before the next one starts
+	integrateBodies();
+	if (detectContacts) {
+		updateBounds();
+		pairList *pairs = updateBroadphase();
+		pruneActiveBodies(&bodies);
+		if (deterministicMode) {
+			sortPairs(pairs);
 		}
-		handleVelocity(object);
-		applyPolygonTransform(object);
+		findContacts(pairs);
+		anchorContacts(&bodies, &contacts);
+	} else {
+		followContactAnchors(&bodies, &contacts);
+	}
+	solveContacts();
+	updateIslands(&islands, &bodies, &contacts, SUBSTEP_FACTOR);
+	if (deterministicMode) {
+		worldHash = hashBodyPool(&bodies);
 	}
 }
 
+// every step becomes a function of the bodies alone, bit for bit: the same bodies created and
+// removed in the same order give the same results no matter how many threads there are, how
+// the jobs got scheduled, or which broadphase is active. worldHash can be compared between
+// machines to catch a desync (as long as they run the same build).
+// the solver and narrowphase already work in a fixed order, what's left is making pairs come out
+// sorted and dropping the support cache, which costs a bit of speed
+void setDeterministicMode(bool enabled) {
+	deterministicMode = enabled;
+	useSupportCache = !enabled;
+}
+
 void drawShapes() {
 	// random colors to choose from
 	Color colors[12] = {BLUE,RED,ORANGE,PURPLE,GREEN,LIME,VIOLET,DARKBLUE,SKYBLUE,MAROON,BROWN,BEIGE};
-	for (int i = 0; i < objectCount; i++) {
-		physicsObject *object = &objectArray[i];
+	for (int i = 0; i < bodies.count; i++) {
+		physicsObject *object = &bodies.objects[i];
+		int slot = bodies.denseToSlot[i];
+		ensureBodyTransform(i);
 		if (IsMouseButtonDown(MOUSE_LEFT_BUTTON)) {
-			if (AABBIntersectPoint(&object->box, GetMousePosition()) && selectedObject == -1) {
-				selectedObject = i;
+			if (AABBIntersectPoint(&bodies.box[i], GetMousePosition()) && getBodyIndex(&bodies, selectedBody) < 0) {
+				selectedBody = getBodyHandle(&bodies, i);
 			}
 		} else {
-			selectedObject = -1;
+			selectedBody = (bodyHandle){NULL_BODY_SLOT, 0};
 		}
-		if (selectedObject == i) {
+		if (getBodyIndex(&bodies, selectedBody) == i) {
 			Vector2 delta = GetMouseDelta();
 			if (object->isStaticBody) {
-				object->position = vec2Add(object->position, delta);
-				applyPolygonTransform(object);
+				// wake whatever it's leaving behind and whatever it's moving into
+				wakeBodiesTouching(&bodies, &bodies.box[i]);
+				bodies.position[i] = vec2Add(bodies.position[i], delta);
+				markTransformDirty(i);
+				ensureBodyTransform(i);
+				wakeBodiesTouching(&bodies, &bodies.box[i]);
 			} else {
-				object->velocity = delta;
+				wakeBody(&bodies, i);
+				bodies.velocity[i] = delta;
 			}
 		}
-		drawPhysicsPolygon(object->collisionShape, colors[i % 12] /*inputting colors*/);
+		drawPhysicsPolygon(object->collisionShape, colors[slot % 12] /*inputting colors*/);
+		AABB *box = &bodies.box[i];
+		DrawRectangleLines(box->min.x - 2, box->min.y - 2, box->max.x - box->min.x + 4, box->max.y - box->min.y + 4, RED);
 	}
 }
 
 void tick(){
 	for (int i = 0; i < SUBSTEP_AMOUNT; i++) {
-		physicsTick();
+		// the first substep of every frame always detects, bodies may have been added or removed
+		physicsTick(i % CONTACT_DETECTION_INTERVAL == 0);
 	}
 	drawShapes();
 }
 
 void cleanupShapes() {
-	for (int i = 0; i < objectCount; i++) {
-		free(objectArray[i].collisionShape->pointArray);
-		free(objectArray[i].collisionShape->globalPointArray);
-		free(objectArray[i].collisionShape);
-	}
+	// every shape goes at once
+	freeShapeAllocator(&shapeMemory);
+	freeShapePrototypeCache(&shapePrototypes);
+	freeBodyPool(&bodies);
+	freeSweepAndPrune(&sweepBroadphase);
+	freePairList(&sweepPairs);
+	freeAABBTree(&treeBroadphase);
+	freeHierarchicalGrid(&gridBroadphase);
+	freePairList(&gridPairs);
+	free(contacts.results);
+	freeContactSolver(&solver);
+	freeSeparatingAxisCache(&satCache);
+	freeIslandBuilder(&islands);
+	free(pairCollisions);
+	pairCollisions = NULL;
+	pairCollisionCapacity = 0;
 }
 
 int main() {
 	SetConfigFlags(FLAG_WINDOW_RESIZABLE);
 	InitWindow(640, 480, "shart2D");
 	SetTargetFPS(60); // 60 fps
+	startJobSystem(&jobs, getJobThreadCount());
 	initializeShapes();
 	while (!WindowShouldClose()) {
 		BeginDrawing();
@@ -341,6 +584,7 @@ int main() {
 		EndDrawing(); // drawing done!
 	}
 	cleanupShapes();
+	stopJobSystem(&jobs);
 
 	CloseWindow();
 	return 0;
@@ -0,0 +1,50 @@
+#include "test.h"
+
+// the box collider has to agree with the general polygon SAT it stands in for
+void checkBoxes(int round) {
+	float size = randomFloat(5.0f, 100.0f);
+	Vector2 dimensions1 = {size, randomFloat(5.0f, 100.0f)};
+	Vector2 dimensions2 = {randomFloat(5.0f, 100.0f), randomFloat(5.0f, 100.0f)};
+	float reach = (vec2Length(dimensions1) + vec2Length(dimensions2)) * 0.5f;
+	// a quarter of them sit square on each other, the way stacked crates do
+	bool aligned = round % 4 == 0;
+	float rotation1 = aligned ? 0.0f : randomFloat(-PI, PI);
+	float rotation2 = aligned ? PI * 0.5f * (int)randomFloat(0.0f, 3.99f) : randomFloat(-PI, PI);
+	Vector2 center2 = {randomFloat(-reach, reach), randomFloat(-reach, reach)};
+	testPair pair = createTestPair(getRectPrototype(&shapePrototypes, dimensions1), rotation1,
+			getRectPrototype(&shapePrototypes, dimensions2), center2, rotation2);
+
+	collisionResult boxes = collideBoxes(pair.shape1, pair.shape2, NULL);
+	collisionResult polygons = collidePolygons(pair.shape1, pair.shape2, NULL);
+	float tolerance = 1e-3f * reach;
+	if (expectSameAsSAT("boxes", boxes, polygons, tolerance)) {
+		expect(boxes.numContacts == polygons.numContacts, "%d contacts, SAT has %d", boxes.numContacts, polygons.numContacts);
+		// two axes that are nearly as shallow as each other can go either way, otherwise the
+		// contacts have to be the same points, though maybe not in the same order
+		bool sameAxis = vec2Dot(boxes.normal, polygons.normal) > 0.999f;
+		Vector2 boxContacts[2] = {boxes.contact1, boxes.contact2};
+		float boxDepths[2] = {boxes.depth1, boxes.depth2};
+		Vector2 polygonContacts[2] = {polygons.contact1, polygons.contact2};
+		float polygonDepths[2] = {polygons.depth1, polygons.depth2};
+		for (int i = 0; sameAxis && i < boxes.numContacts && boxes.numContacts == polygons.numContacts; i++) {
+			int match = -1;
+			for (int j = 0; j < polygons.numContacts; j++) {
+				if (vec2Dist(boxContacts[i], polygonContacts[j]) < tolerance) {
+					match = j;
+				}
+			}
+			expect(match >= 0, "contact (%.3f, %.3f) isn't one SAT found", boxContacts[i].x, boxContacts[i].y);
+			if (match >= 0) {
+				expect(fabsf(boxDepths[i] - polygonDepths[match]) < tolerance, "contact depth %.4f, SAT says %.4f", boxDepths[i], polygonDepths[match]);
+			}
+		}
+	}
+	destroyTestPair(&pair);
+}
+
+int main() {
+	for (int round = 0; round < 50000; round++) {
+		checkBoxes(round);
+	}
+	return finishTest("boxes");
+}
@@ -0,0 +1,92 @@
+#include "test.h"
+
+// brute force distance between the capsule's core and the polygon, 0 when they overlap
+float getCoreDistance(polygonCollisionShape *polygon, Vector2 start, Vector2 end) {
+	Vector2 *points = polygon->globalPointArray;
+	int numPoints = polygon->numPoints;
+	bool startInside = true;
+	float distance = INFINITY;
+	for (int i = 0; i < numPoints; i++) {
+		if (vec2Dot(polygon->globalEdgeNormals[i], vec2Sub(start, points[i])) > 0.0f) {
+			startInside = false;
+		}
+		Vector2 closestPolygon, closestCapsule;
+		closestPointsOnSegments(points[i], points[(i + 1) % numPoints], start, end, &closestPolygon, &closestCapsule);
+		distance = fminf(distance, vec2Dist(closestPolygon, closestCapsule));
+	}
+	return startInside ? 0.0f : distance;
+}
+
+// drops a capsule somewhere around the polygon and checks the collider against the true distance
+void checkCapsuleAgainst(shapePrototype *prototype, float size) {
+	float length = randomFloat(0.0f, size * 2.0f);
+	float radius = randomFloat(1.0f, size * 0.5f);
+	float reach = size + length * 0.5f + radius;
+	bodyHandle polygonBody = createPhysicsBody(prototype, (Vector2){0.0f, 0.0f}, randomFloat(-PI, PI), false, 1.0f, 1.0f);
+	Vector2 center = {randomFloat(-reach, reach), randomFloat(-reach, reach)};
+	bodyHandle capsuleBody = createPhysicsCapsule(center, length, radius, randomFloat(-PI, PI), false, 1.0f, 1.0f);
+	// sometimes lie flat along one of the polygon's faces, where the clipping does the work
+	if (randomFloat(0.0f, 1.0f) < 0.25f) {
+		int polygonIndex = getBodyIndex(&bodies, polygonBody);
+		ensureBodyTransform(polygonIndex);
+		polygonCollisionShape *polygon = bodies.objects[polygonIndex].collisionShape;
+		int edge = (int)randomFloat(0.0f, (float)polygon->numPoints - 0.01f);
+		Vector2 normal = polygon->globalEdgeNormals[edge];
+		Vector2 along = vec2Scale(vec2Add(polygon->globalPointArray[edge], polygon->globalPointArray[(edge + 1) % polygon->numPoints]), 0.5f);
+		along = vec2Add(along, vec2Scale(vec2Perp(normal), randomFloat(-size, size)));
+		int capsuleIndex = getBodyIndex(&bodies, capsuleBody);
+		bodies.position[capsuleIndex] = vec2Add(along, vec2Scale(normal, randomFloat(-radius, radius * 1.2f)));
+		setBodyRotation(&bodies, capsuleIndex, atan2f(normal.x, -normal.y) + randomFloat(-0.01f, 0.01f));
+		markTransformDirty(capsuleIndex);
+	}
+	int polygonIndex = getBodyIndex(&bodies, polygonBody);
+	int capsuleIndex = getBodyIndex(&bodies, capsuleBody);
+	ensureBodyTransform(polygonIndex);
+	ensureBodyTransform(capsuleIndex);
+	polygonCollisionShape *polygon = bodies.objects[polygonIndex].collisionShape;
+	polygonCollisionShape *capsule = bodies.objects[capsuleIndex].collisionShape;
+
+	collisionResult result = collideShapes(polygon, capsule, NULL);
+	float distance = getCoreDistance(polygon, capsule->globalPointArray[0], capsule->globalPointArray[1]);
+	float tolerance = 1e-3f * reach;
+	if (distance < radius - tolerance) {
+		expect(result.isCollided && result.numContacts > 0, "missed a capsule %.4f into the polygon", radius - distance);
+	} else if (distance > radius + tolerance) {
+		expect(!result.isCollided, "capsule %.4f away from the polygon collided", distance - radius);
+	}
+	if (result.isCollided) {
+		expect(fabsf(vec2Length(result.normal) - 1.0f) < 1e-3f, "normal isn't unit length");
+		if (distance > tolerance) {
+			// apart cores are as deep as they are close, not as deep as some face says
+			expect(fabsf(result.penetrationDepth - (radius - distance)) < tolerance,
+					"depth %.4f for a capsule %.4f into the polygon", result.penetrationDepth, radius - distance);
+		} else {
+			expect(result.penetrationDepth >= radius - tolerance, "overlapping cores only %.4f deep", result.penetrationDepth);
+		}
+		float depths[2] = {result.depth1, result.depth2};
+		for (int i = 0; i < result.numContacts; i++) {
+			expect(depths[i] <= result.penetrationDepth + tolerance, "a contact is deeper than the whole collision");
+		}
+	}
+	destroyPhysicsObject(polygonBody);
+	destroyPhysicsObject(capsuleBody);
+}
+
+int main() {
+	for (int i = 0; i < 20000; i++) {
+		float size = randomFloat(5.0f, 100.0f);
+		checkCapsuleAgainst(getRectPrototype(&shapePrototypes, (Vector2){size, randomFloat(5.0f, 100.0f)}), size);
+	}
+	for (int i = 0; i < 20000; i++) {
+		// a random regular polygon
+		float size = randomFloat(5.0f, 100.0f);
+		int numPoints = 3 + (int)randomFloat(0.0f, 9.99f);
+		Vector2 points[13];
+		for (int k = 0; k < numPoints; k++) {
+			float angle = k * 2.0f * PI / numPoints;
+			points[k] = (Vector2){size * 0.5f * cosf(angle), size * 0.5f * sinf(angle)};
+		}
+		checkCapsuleAgainst(createShapePrototype(&shapePrototypes, points, numPoints), size);
+	}
+	return finishTest("capsules");
+}
@@ -0,0 +1,82 @@
+#include "test.h"
+#include <sys/wait.h>
+
+// a mixed scene with bodies coming and going, run in deterministic mode
+unsigned long long runScene(int threadCount, broadphaseType broadphase) {
+	startJobSystem(&jobs, threadCount);
+	activeBroadphase = broadphase;
+	setDeterministicMode(true);
+
+	createPhysicsRect((Vector2){400, 500}, (Vector2){4000, 50}, 0.0f, true, 5.0f, 1.0f);
+	// enough points to go through GJK
+	Vector2 points[24];
+	for (int i = 0; i < 24; i++) {
+		points[i] = (Vector2){30.0f * cosf(i * 2.0f * PI / 24), 30.0f * sinf(i * 2.0f * PI / 24)};
+	}
+	shapePrototype *round = createShapePrototype(&shapePrototypes, points, 24);
+	for (int i = 0; i < 400; i++) {
+		Vector2 center = {randomFloat(-800.0f, 1600.0f), randomFloat(-1500.0f, 400.0f)};
+		switch (i % 5) {
+			case 0: createPhysicsRect(center, (Vector2){randomFloat(10.0f, 40.0f), randomFloat(10.0f, 40.0f)}, 0.3f, false, 1.0f, 1.0f); break;
+			case 1: createPhysicsCircle(center, randomFloat(5.0f, 20.0f), false, 1.0f, 1.0f); break;
+			case 2: createPhysicsCapsule(center, randomFloat(10.0f, 40.0f), randomFloat(5.0f, 13.0f), 0.5f, false, 1.0f, 1.0f); break;
+			case 3: createPhysicsBody(round, center, 0.1f, false, 1.0f, 1.0f); break;
+			default: createPhysicsRect(center, (Vector2){20, 20}, 0.0f, false, 1.0f, 1.0f); break;
+		}
+	}
+	for (int frame = 0; frame < 120; frame++) {
+		tick();
+		if (frame % 30 == 15) {
+			int index = (int)randomFloat(1.0f, (float)bodies.count - 0.01f);
+			destroyPhysicsObject(getBodyHandle(&bodies, index));
+			createPhysicsCircle((Vector2){randomFloat(0.0f, 800.0f), -200.0f}, 10.0f, false, 1.0f, 1.0f);
+		}
+	}
+	stopJobSystem(&jobs);
+	return worldHash;
+}
+
+// every run gets a fresh world of its own in a child process
+unsigned long long runSceneInChild(int threadCount, broadphaseType broadphase) {
+	int fds[2];
+	if (pipe(fds) != 0) {
+		return 0;
+	}
+	pid_t child = fork();
+	if (child == 0) {
+		unsigned long long hash = runScene(threadCount, broadphase);
+		ssize_t written = write(fds[1], &hash, sizeof(hash));
+		_exit(written == sizeof(hash) ? 0 : 1);
+	}
+	close(fds[1]);
+	unsigned long long hash = 0;
+	if (read(fds[0], &hash, sizeof(hash)) != sizeof(hash)) {
+		hash = 0;
+	}
+	close(fds[0]);
+	waitpid(child, NULL, 0);
+	return hash;
+}
+
+int main() {
+	struct {
+		int threadCount;
+		broadphaseType broadphase;
+	} runs[] = {
+		{1, BROADPHASE_SWEEP_AND_PRUNE},
+		{4, BROADPHASE_SWEEP_AND_PRUNE},
+		{8, BROADPHASE_SWEEP_AND_PRUNE},
+		{4, BROADPHASE_AABB_TREE},
+		{4, BROADPHASE_HIERARCHICAL_GRID},
+		{8, BROADPHASE_HIERARCHICAL_GRID},
+	};
+	int runCount = sizeof(runs) / sizeof(runs[0]);
+	unsigned long long expected = runSceneInChild(runs[0].threadCount, runs[0].broadphase);
+	expect(expected != 0, "the first run didn't finish");
+	for (int i = 1; i < runCount; i++) {
+		unsigned long long hash = runSceneInChild(runs[i].threadCount, runs[i].broadphase);
+		expect(hash == expected, "%d threads with broadphase %d hashed to %016llx, 1 thread with sweep and prune to %016llx",
+				runs[i].threadCount, runs[i].broadphase, hash, expected);
+	}
+	return finishTest("determinism");
+}
@@ -0,0 +1,62 @@
+#include "test.h"
+
+// a convex polygon with its points at random angles around an ellipse
+shapePrototype *createRandomPolygon(int numPoints, float size) {
+	float angles[64];
+	for (int i = 0; i < numPoints; i++) {
+		float angle = randomFloat(0.0f, 2.0f * PI);
+		int j = i;
+		while (j > 0 && angles[j - 1] > angle) {
+			angles[j] = angles[j - 1];
+			j--;
+		}
+		angles[j] = angle;
+	}
+	float width = size * randomFloat(0.5f, 1.0f);
+	float height = size * randomFloat(0.5f, 1.0f);
+	Vector2 points[64];
+	for (int i = 0; i < numPoints; i++) {
+		points[i] = (Vector2){width * cosf(angles[i]), height * sinf(angles[i])};
+	}
+	return createShapePrototype(&shapePrototypes, points, numPoints);
+}
+
+// GJK and EPA have to agree with SAT on the pairs they take over from it
+void checkPolygons() {
+	float size1 = randomFloat(5.0f, 100.0f);
+	float size2 = randomFloat(5.0f, 100.0f);
+	shapePrototype *prototype1 = createRandomPolygon(3 + (int)randomFloat(0.0f, 39.99f), size1);
+	shapePrototype *prototype2 = createRandomPolygon(3 + (int)randomFloat(0.0f, 39.99f), size2);
+	float reach = size1 + size2;
+	float rotation1 = randomFloat(-PI, PI);
+	Vector2 center2 = {randomFloat(-reach, reach), randomFloat(-reach, reach)};
+	float rotation2 = randomFloat(-PI, PI);
+	testPair pair = createTestPair(prototype1, rotation1, prototype2, center2, rotation2);
+	polygonCollisionShape *shape1 = pair.shape1;
+	polygonCollisionShape *shape2 = pair.shape2;
+
+	collisionResult gjk = gjkPolygonIntersect(shape1, shape2);
+	collisionResult sat = polygonIntersect(shape1, shape2, NULL);
+	// EPA stops within EPA_TOLERANCE of the true depth, give the floats a bit on top
+	float tolerance = EPA_TOLERANCE + 1e-4f * reach;
+	if (expectSameAsSAT("GJK", gjk, sat, tolerance)) {
+		// two axes that are nearly as shallow as each other can go either way, but the shapes have to
+		// overlap along GJK's normal by as little as they do along SAT's
+		if (vec2Dot(gjk.normal, sat.normal) < 0.999f) {
+			float min1, max1, min2, max2;
+			projectShapeOntoAxis(shape1, gjk.normal, &min1, &max1);
+			projectShapeOntoAxis(shape2, gjk.normal, &min2, &max2);
+			float overlap = fminf(max1, max2) - fmaxf(min1, min2);
+			expect(fabsf(overlap - sat.penetrationDepth) < tolerance, "normal (%.3f, %.3f) overlaps %.4f, SAT's (%.3f, %.3f) %.4f",
+					gjk.normal.x, gjk.normal.y, overlap, sat.normal.x, sat.normal.y, sat.penetrationDepth);
+		}
+	}
+	destroyTestPair(&pair);
+}
+
+int main() {
+	for (int i = 0; i < 20000; i++) {
+		checkPolygons();
+	}
+	return finishTest("gjk");
+}
@@ -0,0 +1,19 @@
+// the tests include the engine directly and never open a window, these stand in for the parts of
+// raylib that main.c links against
+void SetConfigFlags(unsigned int flags) {}
+void InitWindow(int width, int height, const char *title) {}
+void SetTargetFPS(int fps) {}
+bool WindowShouldClose(void) { return true; }
+void CloseWindow(void) {}
+void BeginDrawing(void) {}
+void EndDrawing(void) {}
+void ClearBackground(Color color) {}
+void DrawFPS(int x, int y) {}
+void DrawRectangleLines(int x, int y, int width, int height, Color color) {}
+void DrawTriangleFan(Vector2 *points, int pointCount, Color color) {}
+void DrawCircleV(Vector2 center, float radius, Color color) {}
+void DrawLineEx(Vector2 start, Vector2 end, float thickness, Color color) {}
+void DrawCircleSector(Vector2 center, float radius, float startAngle, float endAngle, int segments, Color color) {}
+bool IsMouseButtonDown(int button) { return false; }
+Vector2 GetMousePosition(void) { return (Vector2){0.0f, 0.0f}; }
+Vector2 GetMouseDelta(void) { return (Vector2){0.0f, 0.0f}; }
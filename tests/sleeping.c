@@ -0,0 +1,71 @@
+#include "test.h"
+
+#define STACK_COUNT 3
+
+// the frame every body of each stack was asleep by, checked while the world runs
+int asleepBy[STACK_COUNT];
+bodyHandle stacks[STACK_COUNT][64];
+int stackSize[STACK_COUNT];
+
+void addToStack(int stack, bodyHandle body) {
+	stacks[stack][stackSize[stack]++] = body;
+}
+
+bool isStackAsleep(int stack) {
+	for (int i = 0; i < stackSize[stack]; i++) {
+		if (bodies.awake[getBodyIndex(&bodies, stacks[stack][i])]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+Vector2 getStackTop(int stack) {
+	return bodies.position[getBodyIndex(&bodies, stacks[stack][stackSize[stack] - 1])];
+}
+
+int main() {
+	// far enough apart that none of the stacks touch
+	createPhysicsRect((Vector2){1000, 500}, (Vector2){3000, 50}, 0.0f, true, 5.0f, 1.0f);
+	for (int i = 0; i < 10; i++) {
+		addToStack(0, createPhysicsRect((Vector2){0, 450 - i * 50.0f}, (Vector2){50, 50}, 0.0f, false, 1.0f, 1.0f));
+	}
+	int rows = 8;
+	for (int row = 0; row < rows; row++) {
+		for (int column = 0; column < rows - row; column++) {
+			Vector2 center = {1000 + (column - (rows - row) / 2.0f) * 21.0f, 465 - row * 20.5f};
+			addToStack(1, createPhysicsRect(center, (Vector2){20, 20}, 0.0f, false, 1.0f, 1.0f));
+		}
+	}
+	// planks with capsules lying between them
+	for (int i = 0; i < 6; i++) {
+		float y = 465 - i * 50.0f;
+		addToStack(2, createPhysicsRect((Vector2){2000, y}, (Vector2){120, 20}, 0.0f, false, 1.0f, 1.0f));
+		addToStack(2, createPhysicsCapsule((Vector2){2000, y - 25}, 80.0f, 15.0f, 0.0f, false, 1.0f, 1.0f));
+	}
+	Vector2 startTop[STACK_COUNT];
+	for (int stack = 0; stack < STACK_COUNT; stack++) {
+		startTop[stack] = getStackTop(stack);
+		asleepBy[stack] = -1;
+	}
+
+	for (int frame = 0; frame < 600; frame++) {
+		tick();
+		for (int stack = 0; stack < STACK_COUNT; stack++) {
+			if (asleepBy[stack] < 0 && isStackAsleep(stack)) {
+				asleepBy[stack] = frame;
+			}
+		}
+	}
+
+	for (int stack = 0; stack < STACK_COUNT; stack++) {
+		expect(asleepBy[stack] >= 0, "stack %d never fell asleep", stack);
+		// once asleep it has to stay asleep, nothing is disturbing it
+		expect(isStackAsleep(stack), "stack %d woke back up after falling asleep by frame %d", stack, asleepBy[stack]);
+		Vector2 top = getStackTop(stack);
+		expect(fabsf(top.x - startTop[stack].x) < 1.0f && fabsf(top.y - startTop[stack].y) < 5.0f,
+				"stack %d's top moved from (%.2f, %.2f) to (%.2f, %.2f), asleep by frame %d", stack,
+				startTop[stack].x, startTop[stack].y, top.x, top.y, asleepBy[stack]);
+	}
+	return finishTest("sleeping");
+}
@@ -0,0 +1,81 @@
+// every test is its own program with the whole engine compiled in, the engine's main is
+// renamed out of the way
+#define main shartMain
+#include "../src/main.c"
+#undef main
+#include "raylibstubs.h"
+
+int testFailures = 0;
+
+// reports a failed check and keeps going, so one run shows every case that broke
+#define expect(condition, ...) \
+	do { \
+		if (!(condition)) { \
+			testFailures++; \
+			fprintf(stderr, "%s:%d: ", __FILE__, __LINE__); \
+			fprintf(stderr, __VA_ARGS__); \
+			fprintf(stderr, "\n"); \
+		} \
+	} while (0)
+
+// same sequence on every platform, unlike rand()
+unsigned long long testRandomState = 0x853c49e6748fea9bull;
+
+float randomFloat(float min, float max) {
+	testRandomState = testRandomState * 6364136223846793005ull + 1442695040888963407ull;
+	return min + (max - min) * (float)(testRandomState >> 40) / (float)(1ull << 24);
+}
+
+// two bodies that are only there to have their shapes collided by hand
+typedef struct {
+	bodyHandle body1;
+	bodyHandle body2;
+	polygonCollisionShape *shape1;
+	polygonCollisionShape *shape2;
+} testPair;
+
+// the first body sits at the origin, both come with their world space points ready
+testPair createTestPair(shapePrototype *prototype1, float rotation1, shapePrototype *prototype2, Vector2 center2, float rotation2) {
+	testPair pair;
+	pair.body1 = createPhysicsBody(prototype1, (Vector2){0.0f, 0.0f}, rotation1, false, 1.0f, 1.0f);
+	pair.body2 = createPhysicsBody(prototype2, center2, rotation2, false, 1.0f, 1.0f);
+	int index1 = getBodyIndex(&bodies, pair.body1);
+	int index2 = getBodyIndex(&bodies, pair.body2);
+	ensureBodyTransform(index1);
+	ensureBodyTransform(index2);
+	pair.shape1 = bodies.objects[index1].collisionShape;
+	pair.shape2 = bodies.objects[index2].collisionShape;
+	return pair;
+}
+
+void destroyTestPair(testPair *pair) {
+	destroyPhysicsObject(pair->body1);
+	destroyPhysicsObject(pair->body2);
+}
+
+// checks a collider called `name` against the general polygon SAT on the same shapes. returns
+// whether both of them collided, so the caller can go on to compare normals and contacts
+bool expectSameAsSAT(const char *name, collisionResult result, collisionResult sat, float tolerance) {
+	if (result.isCollided != sat.isCollided) {
+		// only shapes that are just touching get to disagree on whether they collide
+		float depth = result.isCollided ? result.penetrationDepth : sat.penetrationDepth;
+		expect(depth < tolerance, "%s says %d, SAT says %d, %.4f deep", name, result.isCollided, sat.isCollided, depth);
+		return false;
+	}
+	if (!result.isCollided) {
+		return false;
+	}
+	expect(result.numContacts > 0 && sat.numContacts > 0, "%s found a collision without any contacts", name);
+	expect(fabsf(result.penetrationDepth - sat.penetrationDepth) < tolerance,
+			"%s depth %.4f, SAT says %.4f", name, result.penetrationDepth, sat.penetrationDepth);
+	return true;
+}
+
+int finishTest(const char *name) {
+	if (testFailures > 0) {
+		fprintf(stderr, "%s: %d failed\n", name, testFailures);
+		return 1;
+	}
+	printf("%s: ok\n", name);
+	return 0;
+}